@@ -0,0 +1,138 @@
+#include <sam/Mnemonic.hpp>
+#include <sam/String.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+	using namespace sam;
+
+	// The lookup used before FindMnemonic: lowercases the word into a new string and switches on its CRC32
+	Mnemonic FindMnemonicByCRC32(std::string_view word) {
+		std::string mnemonic(word);
+		std::transform(mnemonic.begin(), mnemonic.end(), mnemonic.begin(), [](char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+
+		switch (CRC32(mnemonic)) {
+		case "nop"_h: return Mnemonic::Nop;
+
+		case "push"_h: return Mnemonic::Push;
+		case "pop"_h: return Mnemonic::Pop;
+		case "load"_h: return Mnemonic::Load;
+		case "store"_h: return Mnemonic::Store;
+		case "lea"_h: return Mnemonic::Lea;
+		case "flea"_h: return Mnemonic::FLea;
+		case "tload"_h: return Mnemonic::TLoad;
+		case "tstore"_h: return Mnemonic::TStore;
+		case "copy"_h: return Mnemonic::Copy;
+		case "swap"_h: return Mnemonic::Swap;
+
+		case "add"_h: return Mnemonic::Add;
+		case "sub"_h: return Mnemonic::Sub;
+		case "mul"_h: return Mnemonic::Mul;
+		case "imul"_h: return Mnemonic::IMul;
+		case "div"_h: return Mnemonic::Div;
+		case "idiv"_h: return Mnemonic::IDiv;
+		case "mod"_h: return Mnemonic::Mod;
+		case "imod"_h: return Mnemonic::IMod;
+		case "neg"_h: return Mnemonic::Neg;
+		case "inc"_h: return Mnemonic::Inc;
+		case "dec"_h: return Mnemonic::Dec;
+
+		case "and"_h: return Mnemonic::And;
+		case "or"_h: return Mnemonic::Or;
+		case "xor"_h: return Mnemonic::Xor;
+		case "not"_h: return Mnemonic::Not;
+		case "shl"_h: return Mnemonic::Shl;
+		case "sal"_h: return Mnemonic::Sal;
+		case "shr"_h: return Mnemonic::Shr;
+		case "sar"_h: return Mnemonic::Sar;
+
+		case "cmp"_h: return Mnemonic::Cmp;
+		case "icmp"_h: return Mnemonic::ICmp;
+		case "jmp"_h: return Mnemonic::Jmp;
+		case "je"_h: return Mnemonic::Je;
+		case "jne"_h: return Mnemonic::Jne;
+		case "ja"_h: return Mnemonic::Ja;
+		case "jae"_h: return Mnemonic::Jae;
+		case "jb"_h: return Mnemonic::Jb;
+		case "jbe"_h: return Mnemonic::Jbe;
+		case "call"_h: return Mnemonic::Call;
+		case "ret"_h: return Mnemonic::Ret;
+
+		case "toi"_h: return Mnemonic::ToI;
+		case "tol"_h: return Mnemonic::ToL;
+		case "tosi"_h: return Mnemonic::ToSi;
+		case "tod"_h: return Mnemonic::ToD;
+		case "top"_h: return Mnemonic::ToP;
+
+		case "null"_h: return Mnemonic::Null;
+		case "new"_h: return Mnemonic::New;
+		case "delete"_h: return Mnemonic::Delete;
+		case "gcnull"_h: return Mnemonic::GCNull;
+		case "gcnew"_h: return Mnemonic::GCNew;
+		case "apush"_h: return Mnemonic::APush;
+		case "anew"_h: return Mnemonic::ANew;
+		case "agcnew"_h: return Mnemonic::AGCNew;
+		case "alea"_h: return Mnemonic::ALea;
+		case "count"_h: return Mnemonic::Count;
+
+		case "string32"_h: return Mnemonic::String32;
+
+		default: return Mnemonic::None;
+		}
+	}
+
+	template<typename F>
+	double Measure(const std::vector<std::string>& words, std::size_t iterations, F&& find, std::uint64_t& checksum) {
+		const auto begin = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			for (const auto& word : words) {
+				checksum += static_cast<std::uint64_t>(find(word));
+			}
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(iterations * words.size());
+	}
+}
+
+int main(int argc, char* argv[]) {
+	const std::size_t iterations = argc > 1 ? static_cast<std::size_t>(std::stoull(argv[1])) : 100000;
+
+	// Every mnemonic in lowercase and uppercase, and words that are not mnemonics
+	std::vector<std::string> words;
+	for (const auto& info : sam::Mnemonics) {
+		std::string upper(info.Name);
+		std::transform(upper.begin(), upper.end(), upper.begin(), [](char c) {
+			return static_cast<char>(std::toupper(c));
+		});
+
+		words.emplace_back(info.Name);
+		words.push_back(std::move(upper));
+	}
+	words.insert(words.end(), { "entrypoint", "loop", "end", "result", "pushes", "j" });
+
+	for (const auto& word : words) {
+		if (sam::FindMnemonic(word) != FindMnemonicByCRC32(word)) {
+			std::cerr << "Error: Mismatched lookup of '" << word << "'.\n";
+			return 1;
+		}
+	}
+
+	std::uint64_t checksum = 0;
+	const double crc32Time = Measure(words, iterations, FindMnemonicByCRC32, checksum);
+	const double tableTime = Measure(words, iterations, sam::FindMnemonic, checksum);
+
+	std::cout << "Words: " << words.size() << ", iterations: " << iterations << " (checksum " << checksum << ")\n";
+	std::cout << "Lowercase and CRC32: " << crc32Time << " ns/lookup\n";
+	std::cout << "FindMnemonic:        " << tableTime << " ns/lookup\n";
+	return 0;
+}
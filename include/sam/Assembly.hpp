@@ -1,10 +1,11 @@
 #pragma once
 
 #include <sam/Function.hpp>
+#include <sam/NameIndex.hpp>
 #include <sam/Structure.hpp>
+#include <sam/SymbolTable.hpp>
 #include <sgn/ByteFile.hpp>
 
-#include <string>
 #include <vector>
 
 namespace sam {
@@ -17,15 +18,23 @@ namespace sam {
 		std::vector<Structure> Structures;
 		std::vector<Function> Functions;
 
-		std::vector<ExternModule>::iterator FindDependency(const std::string& path);
-		std::vector<ExternModule>::iterator FindDependencyByNameSpace(const std::string& nameSpace);
-		ExternModule& GetDependency(const std::string& path);
-		bool HasDependency(const std::string& path);
-		std::vector<Structure>::iterator FindStructure(const std::string& name);
-		Structure& GetStructure(const std::string& name);
-		bool HasStructure(const std::string& name);
-		std::vector<Function>::iterator FindFunction(const std::string& name);
-		Function& GetFunction(const std::string& name);
-		bool HasFunction(const std::string& name);
+		NameIndex DependencyPaths;
+		NameIndex DependencyNameSpaces;
+		NameIndex StructureNames;
+		NameIndex FunctionNames;
+
+		ExternModule& AddDependency(ExternModule dependency);
+		std::vector<ExternModule>::iterator FindDependency(Symbol path);
+		std::vector<ExternModule>::iterator FindDependencyByNameSpace(Symbol nameSpace);
+		ExternModule& GetDependency(Symbol path);
+		bool HasDependency(Symbol path);
+		Structure& AddStructure(Structure structure);
+		std::vector<Structure>::iterator FindStructure(Symbol name);
+		Structure& GetStructure(Symbol name);
+		bool HasStructure(Symbol name);
+		Function& AddFunction(Function function);
+		std::vector<Function>::iterator FindFunction(Symbol name);
+		Function& GetFunction(Symbol name);
+		bool HasFunction(Symbol name);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <sam/Assembly.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sam {
+	struct BuildRecord final {
+		struct Input final {
+			std::string Path;
+			std::uint64_t ContentHash = 0;
+		};
+
+		std::uint64_t OptionHash = 0;
+		std::vector<Input> Inputs; // The assembled file comes first, then every module it depends on
+
+		void AddInput(std::string path, std::uint64_t contentHash);
+		void AddInputs(const Assembly& assembly);
+		bool IsUpToDate() const;
+
+		static std::optional<BuildRecord> Load(const std::string& path);
+		bool Store(const std::string& path) const;
+		bool WriteDepfile(const std::string& path, const std::string& target) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <sam/Instruction.hpp>
+#include <sgn/ByteFile.hpp>
+#include <sgn/Operand.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace sam {
+	class ConstantPool final {
+	private:
+		struct Constant final {
+			std::uint64_t Bits;
+			std::size_t ReferenceCount;
+		};
+		struct Table final {
+			std::vector<Constant> Constants;
+			std::unordered_map<std::uint64_t, std::uint32_t> Indices; // Key: bit pattern
+			std::vector<std::uint32_t> Relocations;
+
+			std::uint32_t Add(std::uint64_t bits, std::size_t referenceCount = 1);
+			std::uint32_t Relocate(std::uint32_t index) const;
+		};
+
+	private:
+		Table m_Ints, m_Longs, m_Singles, m_Doubles;
+		std::size_t m_ReferenceCount = 0;
+
+	public:
+		ConstantPool() = default;
+		ConstantPool(const ConstantPool&) = delete;
+		~ConstantPool() = default;
+
+	public:
+		ConstantPool& operator=(const ConstantPool&) = delete;
+		bool operator==(const ConstantPool&) = delete;
+		bool operator!=(const ConstantPool&) = delete;
+
+	public:
+		sgn::IntConstantIndex AddIntConstant(std::uint32_t value);
+		sgn::LongConstantIndex AddLongConstant(std::uint64_t value);
+		sgn::SingleConstantIndex AddSingleConstant(float value);
+		sgn::DoubleConstantIndex AddDoubleConstant(double value);
+
+		void Merge(ConstantPool& pool);
+		void Generate(sgn::ByteFile& byteFile);
+		void Relocate(std::vector<LoweredInstruction>& instructions) const;
+
+		std::size_t GetReferenceCount() const noexcept;
+		std::size_t GetConstantCount() const noexcept;
+	};
+}
\ No newline at end of file
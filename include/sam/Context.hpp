@@ -0,0 +1,67 @@
+#pragma once
+
+#include <sam/ModuleCache.hpp>
+#include <sam/ModuleRegistry.hpp>
+#include <sam/Profile.hpp>
+#include <sam/Source.hpp>
+#include <sam/SymbolTable.hpp>
+#include <sam/ThreadPool.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sam {
+	struct Statistics final {
+		std::size_t InputFiles = 0;
+		std::size_t MappedInputFiles = 0;
+		std::uint64_t InputBytes = 0;
+		std::size_t CachedModules = 0;
+		std::size_t ReusedModules = 0;
+		std::size_t SkippedOutputs = 0;
+		std::size_t EliminatedInstructions = 0;
+		std::size_t InlinedCalls = 0;
+		std::size_t EliminatedTailCalls = 0;
+		std::size_t SharedLocalVariables = 0;
+		std::size_t RemovedFunctions = 0;
+		std::size_t RemovedStructures = 0;
+		std::size_t VerifiedFunctions = 0;
+		std::size_t MaxStackDepth = 0;
+		std::size_t ConstantReferences = 0;
+		std::size_t Constants = 0;
+		std::chrono::nanoseconds ReadTime{};
+		std::chrono::nanoseconds LexTime{};
+		std::mutex Mutex;
+
+		void AddInput(const Source& source, std::chrono::nanoseconds readTime, std::chrono::nanoseconds lexTime);
+		void AddCachedModule();
+		void AddReusedModule();
+		void AddSkippedOutput();
+		void AddEliminatedInstructions(std::size_t count);
+		void AddInlinedCalls(std::size_t count);
+		void AddEliminatedTailCalls(std::size_t count);
+		void AddSharedLocalVariables(std::size_t count);
+		void AddRemovedSections(std::size_t functionCount, std::size_t structureCount);
+		void AddVerifiedFunction(std::size_t maxStackDepth);
+		void AddConstants(std::size_t referenceCount, std::size_t constantCount);
+	};
+}
+
+namespace sam {
+	struct Context final {
+		std::vector<const char*> ImportDirectories;
+		bool UseMultiPass = false;
+		unsigned OptimizationLevel = 0;
+		bool UseGcSections = false;
+		bool UseStaticLinking = false;
+		std::unique_ptr<sam::ThreadPool> ThreadPool;
+		std::unique_ptr<sam::ModuleCache> ModuleCache;
+		std::unique_ptr<sam::Profile> Profile;
+		ModuleRegistry Modules;
+		SymbolTable Symbols;
+		sam::Statistics Statistics;
+	};
+}
\ No newline at end of file
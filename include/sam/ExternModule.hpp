@@ -1,15 +1,27 @@
 #pragma once
 
 #include <sam/Assembly.hpp>
+#include <sam/Lexer.hpp>
+#include <sam/Source.hpp>
+#include <sam/SymbolTable.hpp>
 #include <sgn/Operand.hpp>
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace sam {
 	struct ExternModule final {
-		std::string Path;
+		Symbol Path;
 		sam::Assembly Assembly;
 		sgn::ExternModuleIndex Index;
-		std::string NameSpace;
+		Symbol NameSpace;
+		std::string ImportPath;
+		std::string SourcePath;
+		std::uint64_t ContentHash = 0;
+
+		std::shared_ptr<const sam::Source> Source;		// Static linking only
+		std::vector<Token> Tokens;						// Static linking only
 	};
 }
\ No newline at end of file
@@ -1,23 +1,27 @@
 #pragma once
 
+#include <sam/Instruction.hpp>
+#include <sam/NameIndex.hpp>
+#include <sam/SymbolTable.hpp>
 #include <sgn/Builder.hpp>
 #include <sgn/Operand.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
-#include <string>
 #include <vector>
 
 namespace sam {
 	struct Label final {
-		std::string Name;
+		Symbol Name;
 		sgn::LabelIndex Index;
 	};
 }
 
 namespace sam {
 	struct LocalVariable final {
-		std::string Name;
+		Symbol Name;
 		sgn::LocalVariableIndex Index;
 	};
 }
@@ -26,19 +30,29 @@ namespace sam {
 	struct Function final {
 		std::unique_ptr<sgn::Builder> Builder;
 
-		std::string Name;
+		Symbol Name;
 		sgn::FunctionIndex Index;
+		std::uint16_t Arity = 0;
+		bool HasResult = false;
+		bool IsInline = false;
 		std::vector<Label> Labels;
 		std::vector<LocalVariable> LocalVariables;
+		std::vector<Instruction> Instructions;
+		std::optional<std::size_t> MaxStackDepth; // Set when the stack is verified before lowering
 
 		std::optional<sgn::ExternFunctionIndex> ExternIndex;
 		std::optional<sgn::MappedFunctionIndex> MappedIndex;
 
-		std::vector<Label>::iterator FindLabel(const std::string& name);
-		Label& GetLabel(const std::string& name);
-		bool HasLabel(const std::string& name);
-		std::vector<LocalVariable>::iterator FindLocalVariable(const std::string& name);
-		LocalVariable& GetLocalVariable(const std::string& name);
-		bool HasLocalVariable(const std::string& name);
+		NameIndex LabelNames;
+		NameIndex LocalVariableNames;
+
+		Label& AddLabel(Label label);
+		std::vector<Label>::iterator FindLabel(Symbol name);
+		Label& GetLabel(Symbol name);
+		bool HasLabel(Symbol name);
+		LocalVariable& AddLocalVariable(LocalVariable localVariable);
+		std::vector<LocalVariable>::iterator FindLocalVariable(Symbol name);
+		LocalVariable& GetLocalVariable(Symbol name);
+		bool HasLocalVariable(Symbol name);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sam/Mnemonic.hpp>
+#include <sam/SymbolTable.hpp>
+#include <sgn/Operand.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+namespace sam {
+	struct Name final {
+		Symbol NameSpace;
+		Symbol Identifier;
+		Symbol Member;
+		Symbol Full;
+	};
+}
+
+namespace sam {
+	struct Type final {
+		Name ElementTypeName;
+		std::optional<std::uint64_t> ElementCount;
+	};
+}
+
+namespace sam {
+	struct StringOperand final {
+		std::string_view Value;
+		Symbol LocalVariable;
+	};
+
+	using Operand = std::variant<std::monostate,
+		std::uint32_t, std::uint64_t, float, double,	// push
+		Symbol,											// load, store, lea, jmp, je, ..., label
+		Name,											// push, flea, call
+		Type,											// new, gcnew, apush, anew, agcnew
+		StringOperand>;									// string32
+
+	struct Instruction final {
+		sam::Mnemonic Mnemonic = sam::Mnemonic::None;
+		sam::Operand Operand;
+		std::size_t Token = 0;
+	};
+}
+
+namespace sam {
+	using LoweredOperand = std::variant<std::monostate,
+		sgn::IntConstantIndex, sgn::LongConstantIndex, sgn::SingleConstantIndex, sgn::DoubleConstantIndex,
+		sgn::StructureIndex, sgn::MappedStructureIndex, sgn::FieldIndex,
+		sgn::FunctionIndex, sgn::MappedFunctionIndex,
+		sgn::LocalVariableIndex, sgn::LabelIndex,
+		sgn::TypeIndex, sgn::ArrayIndex,
+		std::string_view>;									// label
+
+	struct LoweredInstruction final {
+		sam::Mnemonic Mnemonic = sam::Mnemonic::None;
+		LoweredOperand Operand;
+	};
+}
\ No newline at end of file
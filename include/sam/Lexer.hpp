@@ -1,7 +1,11 @@
 #pragma once
 
+#include <sam/Source.hpp>
+#include <sam/SymbolTable.hpp>
+
 #include <cstddef>
-#include <istream>
+#include <cstdint>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -10,7 +14,7 @@
 #include <vector>
 
 namespace sam {
-	enum class TokenType {
+	enum class TokenType : std::uint8_t {
 		None,
 		NewLine,
 
@@ -54,20 +58,21 @@ namespace sam {
 	constexpr bool IsTypeKeyword(TokenType type) noexcept;
 	constexpr bool IsInteger(TokenType type) noexcept;
 
-	using TokenData = std::variant<std::monostate, std::uint64_t, double, std::string>;
+	using TokenData = std::variant<std::monostate, std::uint64_t, double, std::string_view, Symbol>;
 
 	struct Token final {
-		std::string Word;
+		std::string_view Word;
 		TokenData Data;
+		std::uint32_t Line = 0;
 		TokenType Type = TokenType::None;
-		std::size_t Line = 0;
-
-		std::string Suffix;
+		std::uint8_t SuffixSize = 0;
 
 		Token() noexcept = default;
-		Token(std::string word, TokenType type, std::size_t line) noexcept;
-		Token(std::string word, TokenData data, TokenType type, std::size_t line) noexcept;
-		Token(std::string word, std::string suffix, TokenData data, TokenType type, std::size_t line) noexcept;
+		Token(std::string_view word, TokenType type, std::size_t line) noexcept;
+		Token(std::string_view word, TokenData data, TokenType type, std::size_t line) noexcept;
+		Token(std::string_view word, std::string_view suffix, TokenData data, TokenType type, std::size_t line) noexcept;
+
+		std::string_view GetSuffix() const noexcept;
 	};
 
 	std::ostream& operator<<(std::ostream& stream, const Token& token);
@@ -77,10 +82,11 @@ namespace sam {
 	class Lexer final {
 	private:
 		std::string m_Path;
-		std::istream& m_InputStream;
+		std::shared_ptr<Source> m_Source;
+		SymbolTable& m_Symbols;
 		std::ostringstream m_ErrorStream;
 
-		std::string m_Line;
+		std::string_view m_Line;
 		std::size_t m_LineNum = 0;
 		std::size_t m_Column = 0;
 
@@ -90,7 +96,7 @@ namespace sam {
 		bool m_HasInfo = false;
 
 	public:
-		Lexer(std::string path, std::istream& inputStream) noexcept;
+		Lexer(std::string path, std::shared_ptr<Source> source, SymbolTable& symbols) noexcept;
 		Lexer(const Lexer&) = delete;
 		~Lexer() = default;
 
@@ -102,6 +108,7 @@ namespace sam {
 	public:
 		void Lex();
 		std::vector<Token> GetTokens() noexcept;
+		std::shared_ptr<const Source> GetSource() const noexcept;
 
 		bool HasError() const noexcept;
 		bool HasMessage() const noexcept;
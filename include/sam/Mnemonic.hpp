@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace sam {
+	enum class Mnemonic : std::uint8_t {
+		None,
+
+		Nop,
+
+		Push,
+		Pop,
+		Load,
+		Store,
+		Lea,
+		FLea,
+		TLoad,
+		TStore,
+		Copy,
+		Swap,
+
+		Add,
+		Sub,
+		Mul,
+		IMul,
+		Div,
+		IDiv,
+		Mod,
+		IMod,
+		Neg,
+		Inc,
+		Dec,
+
+		And,
+		Or,
+		Xor,
+		Not,
+		Shl,
+		Sal,
+		Shr,
+		Sar,
+
+		Cmp,
+		ICmp,
+		Jmp,
+		Je,
+		Jne,
+		Ja,
+		Jae,
+		Jb,
+		Jbe,
+		Call,
+		Ret,
+
+		ToI,
+		ToL,
+		ToSi,
+		ToD,
+		ToP,
+
+		Null,
+		New,
+		Delete,
+		GCNull,
+		GCNew,
+		APush,
+		ANew,
+		AGCNew,
+		ALea,
+		Count,
+
+		String32,				// ShitAsm Extension
+		Label,					// Pseudo instruction
+	};
+
+	struct MnemonicInfo final {
+		std::string_view Name;
+		sam::Mnemonic Mnemonic;
+	};
+
+	constexpr MnemonicInfo Mnemonics[] = {
+		{ "nop", Mnemonic::Nop },
+
+		{ "push", Mnemonic::Push },
+		{ "pop", Mnemonic::Pop },
+		{ "load", Mnemonic::Load },
+		{ "store", Mnemonic::Store },
+		{ "lea", Mnemonic::Lea },
+		{ "flea", Mnemonic::FLea },
+		{ "tload", Mnemonic::TLoad },
+		{ "tstore", Mnemonic::TStore },
+		{ "copy", Mnemonic::Copy },
+		{ "swap", Mnemonic::Swap },
+
+		{ "add", Mnemonic::Add },
+		{ "sub", Mnemonic::Sub },
+		{ "mul", Mnemonic::Mul },
+		{ "imul", Mnemonic::IMul },
+		{ "div", Mnemonic::Div },
+		{ "idiv", Mnemonic::IDiv },
+		{ "mod", Mnemonic::Mod },
+		{ "imod", Mnemonic::IMod },
+		{ "neg", Mnemonic::Neg },
+		{ "inc", Mnemonic::Inc },
+		{ "dec", Mnemonic::Dec },
+
+		{ "and", Mnemonic::And },
+		{ "or", Mnemonic::Or },
+		{ "xor", Mnemonic::Xor },
+		{ "not", Mnemonic::Not },
+		{ "shl", Mnemonic::Shl },
+		{ "sal", Mnemonic::Sal },
+		{ "shr", Mnemonic::Shr },
+		{ "sar", Mnemonic::Sar },
+
+		{ "cmp", Mnemonic::Cmp },
+		{ "icmp", Mnemonic::ICmp },
+		{ "jmp", Mnemonic::Jmp },
+		{ "je", Mnemonic::Je },
+		{ "jne", Mnemonic::Jne },
+		{ "ja", Mnemonic::Ja },
+		{ "jae", Mnemonic::Jae },
+		{ "jb", Mnemonic::Jb },
+		{ "jbe", Mnemonic::Jbe },
+		{ "call", Mnemonic::Call },
+		{ "ret", Mnemonic::Ret },
+
+		{ "toi", Mnemonic::ToI },
+		{ "tol", Mnemonic::ToL },
+		{ "tosi", Mnemonic::ToSi },
+		{ "tod", Mnemonic::ToD },
+		{ "top", Mnemonic::ToP },
+
+		{ "null", Mnemonic::Null },
+		{ "new", Mnemonic::New },
+		{ "delete", Mnemonic::Delete },
+		{ "gcnull", Mnemonic::GCNull },
+		{ "gcnew", Mnemonic::GCNew },
+		{ "apush", Mnemonic::APush },
+		{ "anew", Mnemonic::ANew },
+		{ "agcnew", Mnemonic::AGCNew },
+		{ "alea", Mnemonic::ALea },
+		{ "count", Mnemonic::Count },
+
+		{ "string32", Mnemonic::String32 },
+	};
+
+	constexpr std::size_t MnemonicCount = std::size(Mnemonics);
+	constexpr std::size_t MnemonicTableSize = 512;
+	constexpr std::size_t MnemonicMaxLength = 8;
+
+	struct MnemonicTable final {
+		std::uint32_t Seed = 0;
+		std::uint8_t Entries[MnemonicTableSize] = {}; // 0: Empty, n: Mnemonics[n - 1]
+	};
+
+	constexpr char ToLower(char c) noexcept;
+	constexpr std::uint32_t HashMnemonic(std::string_view mnemonic, std::uint32_t seed) noexcept;
+	constexpr MnemonicTable MakeMnemonicTable() noexcept;
+	constexpr Mnemonic FindMnemonic(std::string_view mnemonic) noexcept;
+}
+
+#include "detail/impl/Mnemonic.hpp"
\ No newline at end of file
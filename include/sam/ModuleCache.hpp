@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sam {
+	struct ModuleInterface final {
+		struct Import final {
+			std::string Path;
+			std::string NameSpace;
+		};
+		struct Field final {
+			std::string Name;
+			std::string TypeName;
+			std::optional<std::uint64_t> ElementCount;
+		};
+		struct Structure final {
+			std::string Name;
+			std::vector<Field> Fields;
+		};
+		struct Function final {
+			std::string Name;
+			std::uint16_t Arity = 0;
+			bool HasResult = false;
+		};
+
+		bool IsComplete = false; // Whether imports and structure fields are included
+		std::uint64_t ContentHash = 0;
+		std::vector<Import> Imports;
+		std::vector<Structure> Structures;
+		std::vector<Function> Functions;
+	};
+}
+
+namespace sam {
+	class ModuleCache final {
+	private:
+		struct Entry final {
+			ModuleInterface Interface;
+			std::uint64_t WriteTime;
+			std::uint64_t Size;
+		};
+
+	private:
+		std::filesystem::path m_Directory;
+
+	public:
+		explicit ModuleCache(std::filesystem::path directory);
+		ModuleCache(const ModuleCache&) = delete;
+		~ModuleCache() = default;
+
+	public:
+		ModuleCache& operator=(const ModuleCache&) = delete;
+		bool operator==(const ModuleCache&) = delete;
+		bool operator!=(const ModuleCache&) = delete;
+
+	public:
+		std::optional<ModuleInterface> Load(std::string_view path) const;
+		std::optional<ModuleInterface> Load(std::string_view path, std::uint64_t contentHash) const;
+		bool Store(std::string_view path, std::uint64_t contentHash, const ModuleInterface& interface) const;
+
+		static std::uint64_t Hash(std::string_view data) noexcept;
+
+	private:
+		std::optional<Entry> LoadEntry(std::string_view path) const;
+		std::filesystem::path GetEntryPath(std::string_view path) const;
+
+		static std::optional<std::pair<std::uint64_t, std::uint64_t>> GetFileState(std::string_view path); // (Write time, Size)
+	};
+}
\ No newline at end of file
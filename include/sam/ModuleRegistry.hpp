@@ -0,0 +1,50 @@
+#pragma once
+
+#include <sam/ModuleCache.hpp>
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sam {
+	class ModuleRegistry final {
+	private:
+		struct Entry final {
+			ModuleInterface Interface;
+			std::filesystem::file_time_type WriteTime;
+		};
+
+	private:
+		std::unordered_map<std::string, Entry> m_Modules; // Key: absolute path of the source file
+		std::unordered_map<std::string, std::vector<std::string>> m_LoadingModules; // (Path, Import chain of the loader)
+		std::vector<std::pair<std::string, std::string>> m_Waits; // (Importing module, Awaited module)
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_LoadedCondition;
+
+	public:
+		ModuleRegistry() = default;
+		ModuleRegistry(const ModuleRegistry&) = delete;
+		~ModuleRegistry() = default;
+
+	public:
+		ModuleRegistry& operator=(const ModuleRegistry&) = delete;
+		bool operator==(const ModuleRegistry&) = delete;
+		bool operator!=(const ModuleRegistry&) = delete;
+
+	public:
+		std::optional<ModuleInterface> Find(const std::string& path) const;
+		void Register(const std::string& path, ModuleInterface interface);
+		bool BeginLoad(const std::string& path, const std::vector<std::string>& importChain);
+		void EndLoad(const std::string& path);
+		std::size_t Revalidate();
+
+	private:
+		bool IsAwaitedBy(const std::string& path, const std::vector<std::string>& importChain) const;
+	};
+}
\ No newline at end of file
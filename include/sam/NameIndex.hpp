@@ -0,0 +1,33 @@
+#pragma once
+
+#include <sam/SymbolTable.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace sam {
+	class NameIndex final {
+	private:
+		std::unordered_map<Symbol, std::size_t> m_Indices;
+
+	public:
+		NameIndex() = default;
+		NameIndex(const NameIndex&) = default;
+		NameIndex(NameIndex&&) noexcept = default;
+		~NameIndex() = default;
+
+	public:
+		NameIndex& operator=(const NameIndex&) = default;
+		NameIndex& operator=(NameIndex&&) noexcept = default;
+		bool operator==(const NameIndex&) = delete;
+		bool operator!=(const NameIndex&) = delete;
+
+	public:
+		void Add(Symbol name, std::size_t index);
+		template<typename T>
+		typename std::vector<T>::iterator Find(std::vector<T>& elements, Symbol name) const;
+	};
+}
+
+#include "detail/impl/NameIndex.hpp"
\ No newline at end of file
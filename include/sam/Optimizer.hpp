@@ -0,0 +1,42 @@
+#pragma once
+
+#include <sam/Assembly.hpp>
+#include <sam/Function.hpp>
+#include <sam/Instruction.hpp>
+#include <sam/SymbolTable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sam {
+	constexpr std::size_t InlineThreshold = 16; // Instructions, including 'ret'
+
+	struct StackMessage final {
+		std::size_t Instruction = 0;
+		bool IsError = false;
+		std::string Message;
+	};
+
+	struct StackInfo final {
+		std::optional<std::size_t> MaxDepth; // Values, not counting local variables. std::nullopt if not verified or unbounded.
+		std::vector<StackMessage> Messages;
+	};
+
+	std::optional<Symbol> GetLocalVariableOperand(const Instruction& instruction) noexcept;
+
+	std::size_t InlineFunctions(Assembly& assembly, SymbolTable& symbols);
+	std::size_t EliminateTailCalls(Function& function, Assembly& assembly, SymbolTable& symbols);
+	std::size_t SimplifyControlFlow(Function& function, Assembly& assembly);
+	std::size_t FoldConstants(Function& function);
+	std::size_t OptimizePeephole(Function& function);
+	std::size_t ShareLocalVariables(Function& function, Assembly& assembly);
+	void LayOutBlocks(Function& function, std::optional<std::uint64_t> entryCount, const std::unordered_map<Symbol, std::uint64_t>& labelCounts, SymbolTable& symbols);
+	std::pair<std::size_t, std::size_t> EliminateUnusedSections(Assembly& assembly, const std::vector<Symbol>& roots = {}); // (Functions, Structures)
+
+	StackInfo VerifyStack(const Function& function, Assembly& assembly);
+}
\ No newline at end of file
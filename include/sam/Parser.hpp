@@ -1,41 +1,91 @@
 #pragma once
 
 #include <sam/Assembly.hpp>
+#include <sam/ConstantPool.hpp>
+#include <sam/Context.hpp>
 #include <sam/Function.hpp>
+#include <sam/Instruction.hpp>
 #include <sam/Lexer.hpp>
+#include <sam/ModuleCache.hpp>
+#include <sam/Source.hpp>
 #include <sam/Structure.hpp>
+#include <sam/SymbolTable.hpp>
+#include <sgn/Builder.hpp>
 #include <sgn/Operand.hpp>
 #include <sgn/Type.hpp>
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
 
-namespace sam {
-	struct Type final {
-		sgn::Type ElementType;
-		std::string ElementTypeName;
-		std::optional<std::uint64_t> ElementCount;
-	};
-}
-
-namespace sam {
-	struct Name final {
-		std::string NameSpace;
-		std::string Identifier;
-		std::string Full;
-	};
-}
-
 namespace sam {
 	class Parser final {
 	private:
-		const std::vector<const char*>& m_ImportDirectories;
+		struct ImportJob final {
+			std::size_t Dependency;
+			std::size_t Token;
+			std::uint32_t Line;
+			std::string Path;
+			std::string RealPath;
+
+			std::unique_ptr<Parser> Module;
+			std::uint64_t ContentHash = 0;
+			std::string Messages;
+			bool IsOpened = false;
+			bool IsCircular = false;
+		};
+		struct String32Initializer final { // ShitAsm Extension
+			sgn::FunctionIndex Index;
+			std::size_t Function; // The first function using the literal, which also lowers the initializer
+			std::unique_ptr<sgn::Builder> Builder;
+			std::vector<LoweredInstruction> Instructions;
+		};
+		enum class ByteFileRequestKind {
+			MapFunction,
+			MapStructure,
+			GetTypeIndex,
+			MakeArray,
+		};
+		struct ByteFileRequest final { // Made while lowering a function, and replayed in order at the join
+			ByteFileRequestKind Kind;
+			ExternModule* Module = nullptr;
+			sam::Function* Function = nullptr;
+			sam::Structure* Structure = nullptr;
+			sgn::Type Type = nullptr;
+			std::size_t ElementType = 0; // MakeArray: index of the GetTypeIndex request
+		};
+		struct LoweringState final { // Owned by the thread lowering the function
+			sam::Function* Function = nullptr;
+			const std::string* Path = nullptr;
+			const std::vector<sam::Token>* Tokens = nullptr;
+			std::size_t Token = 0;
+			std::ostringstream Messages;
+			bool HasError = false;
+			bool HasWarning = false;
+
+			ConstantPool Constants;
+			std::vector<ByteFileRequest> Requests; // Operands of type TypeIndex, ArrayIndex, MappedFunctionIndex and MappedStructureIndex refer to these
+			std::vector<LoweredInstruction> Instructions;
+		};
+		struct TypeReference final {
+			sgn::Type Type = nullptr; // Fundamental types only
+			sam::Structure* Structure = nullptr;
+			ExternModule* Module = nullptr; // Not null if the structure has to be mapped
+		};
+
+	private:
+		Context& m_Context;
 		std::string m_Path;
+		std::shared_ptr<const Source> m_Source;
 		std::vector<Token> m_Tokens;
 		std::ostringstream m_ErrorStream;
 		int m_Depth = 0;
@@ -44,15 +94,27 @@ namespace sam {
 		Token m_EmptyToken;
 		Structure* m_CurrentStructure = nullptr;
 		Function* m_CurrentFunction = nullptr;
+		std::vector<std::pair<std::size_t, std::size_t>> m_FieldLines; // (Structure, Token)
+		std::vector<ImportJob> m_Imports;
+		std::vector<std::string> m_ImportChain; // Absolute paths of the importing modules
+		std::unordered_set<Symbol> m_LinkedModules; // Key: path of the module linked statically
+		std::unordered_map<Symbol, ExternModule*> m_LinkedFunctions; // (Linked name, Module)
+		std::vector<ExternModule*> m_ExternModules; // Standard modules that stay extern when linking statically
+		std::size_t m_ModuleStructureCount = 0;
+		std::size_t m_ModuleFunctionCount = 0;
+		std::unordered_map<std::string_view, std::size_t> m_String32Literals; // (Value, Reference count)
+		std::unordered_map<std::string_view, std::size_t> m_String32Functions; // (Value, Initializer)
+		std::vector<String32Initializer> m_String32Initializers;
 
 		Assembly m_Result;
+		ConstantPool m_Constants;
 		bool m_HasError = false;
 		bool m_HasWarning = false;
 		bool m_HasInfo = false;
 
 	public:
-		Parser(const std::vector<const char*>& importDirectories,
-			std::string path, std::vector<Token> tokens, int depth) noexcept;
+		Parser(Context& context,
+			std::string path, std::shared_ptr<const Source> source, std::vector<Token> tokens, int depth) noexcept;
 		Parser(const Parser&) = delete;
 		~Parser() = default;
 
@@ -61,17 +123,24 @@ namespace sam {
 
 	public:
 		void Parse();
+		bool Load(const ModuleInterface& interface);
 		Assembly GetAssembly() noexcept;
+		ModuleInterface GetInterface() const;
 
 		bool HasError() const noexcept;
 		bool HasMessage() const noexcept;
 		std::string GetMessages() const;
 
 	private:
+		bool IsPrototypeOnly() const noexcept;
+		bool IsLinkedStatically() const noexcept;
 		void ResetState() noexcept;
 		const Token& GetToken(std::size_t i) const noexcept;
+		std::string_view GetString(Symbol symbol) const noexcept;
+		Name MakeName(std::string_view full);
 		bool Accept(const Token*& token, TokenType type) noexcept;
 		bool AcceptOr(const Token*& token, TokenType typeA, TokenType typeB) noexcept;
+		bool IsInlineModifier() const noexcept;
 		bool NextLine(int hasError);
 
 		bool Pass(int(Parser::*function)(), bool isFirst);
@@ -79,56 +148,89 @@ namespace sam {
 		bool SecondPass();
 		bool ThirdPass();
 		bool FourthPass();
+		bool SinglePass();
+		bool ResolveFields();
 		void GenerateBuilders();
+		void GenerateBuilder(Function& func);
+		void GenerateFields(Structure& structure);
+		void RemoveUnusedSections();
+		void SortFunctionsByProfile();
+		void LayOutSections();
+		void LinkModules();
+		void LinkModule(ExternModule& module);
+		void LinkNames(Assembly& assembly, Symbol modulePath, std::vector<Instruction>& instructions);
+		Name GetLinkedName(Assembly& assembly, Symbol modulePath, const Name& name, bool isFunction);
+		void AddExternModule(ExternModule& module);
+		ExternModule* FindExternModule(Symbol path) noexcept;
+		bool IsNativeModule(const ExternModule& module) const noexcept;
 
 		bool IgnoreImport();
 		bool IgnoreStructure();
 		bool IgnoreFunction();
 		bool IgnoreLabel();
 
+		int ParseLine();
+
 		int ParsePrototypes();
 		bool ParseStructure();
-		bool ParseFunction(bool hasResult);
+		bool ParseFunction(bool hasResult, bool isInline = false);
+		bool ParseInlineFunction();
 		bool ParseLabel();
 
 		int ParseDependencies();
 		std::optional<Name> ParseName(const std::string& required, int dot, bool isType, bool isField = false);
 		bool ParseExternModule(const Name& namespaceName, const std::string& path);
+		void LoadExternModule(ImportJob& job) const;
+		void ReadExternModule(ImportJob& job, const std::string& modulePath) const;
+		std::unique_ptr<Parser> CreateModule(const ImportJob& job, const std::string& modulePath,
+			std::shared_ptr<const Source> source, std::vector<Token> tokens) const;
+		bool LinkExternModule(ImportJob& job);
+		void DeclareExternModule(ExternModule& module);
+		bool ResolveImports();
 		bool ParseImport();
 
 		int ParseFields();
 		std::variant<std::monostate, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t, float, double> ParseNumber();
 		std::variant<std::monostate, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t, float, double> MakeNegative(std::variant<std::uint32_t, std::uint64_t, float, double> literal, bool isNegative);
 		bool IsNegative(std::variant<std::monostate, std::int32_t, std::uint32_t, std::int64_t, std::uint64_t, float, double> value);
-		sgn::Type GetType(const Name& name, const Structure** outStructure = nullptr);
+		sgn::Type GetType(const Name& name);
 		std::optional<Type> ParseType(bool isField = false);
 		bool ParseField();
 
 		int ParseInstructions();
 		bool ParseInstruction();
-		bool ParsePushInstruction();
-		bool ParseLoadInstruction();
-		bool ParseStoreInstruction();
-		bool ParseLeaInstruction();
-		bool ParseFLeaInstruction();
-		bool ParseJmpInstruction();
-		bool ParseJeInstruction();
-		bool ParseJneInstruction();
-		bool ParseJaInstruction();
-		bool ParseJaeInstruction();
-		bool ParseJbInstruction();
-		bool ParseJbeInstruction();
-		bool ParseCallInstruction();
-		bool ParseNewInstruction();
-		bool ParseGCNewInstruction();
-		bool ParseAPushInstruction();
-		bool ParseANewInstruction();
-		bool ParseAGCNewInstruction();
-		bool ParseString32Statement(); // ShitAsm Extension
-
-		std::optional<sgn::FieldIndex> GetField(const Name& name);
-		std::variant<std::monostate, sgn::FunctionIndex, sgn::MappedFunctionIndex> GetFunction(const Name& name);
-		std::optional<sgn::LabelIndex> GetLabel(const std::string& name);
-		std::optional<sgn::LocalVariableIndex> GetLocalVaraible(const std::string& name);
+		std::optional<Operand> ParsePushOperand();
+		std::optional<Operand> ParseLocalVariableOperand();
+		std::optional<Operand> ParseLabelOperand();
+		std::optional<Operand> ParseNameOperand(const std::string& required, int dot, bool isType = false);
+		std::optional<Operand> ParseTypeOperand(Mnemonic mnemonic);
+		std::optional<Operand> ParseString32Operand(); // ShitAsm Extension
+
+		bool EmitInstructions();
+		static void EmitInstructions(sgn::Builder& builder, const std::vector<LoweredInstruction>& instructions);
+
+		void PrepareString32Initializers(); // ShitAsm Extension
+		void LowerFunction(LoweringState& state);
+		void JoinFunction(LoweringState& state, std::size_t function);
+		static std::uint32_t AddRequest(LoweringState& state, const ByteFileRequest& request);
+		std::vector<std::uint32_t> ReplayRequests(const std::vector<ByteFileRequest>& requests);
+		static void RelocateRequests(const std::vector<std::uint32_t>& indices, std::vector<LoweredInstruction>& instructions);
+
+		const Token& GetToken(const LoweringState& state) const noexcept;
+		bool VerifyFunction(LoweringState& state);
+		bool LowerInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output);
+		bool LowerPushInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output);
+		bool LowerLocalVariableInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output);
+		bool LowerTypeInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output);
+		bool LowerString32Statement(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output); // ShitAsm Extension
+		void LowerString32Array(LoweringState& state, std::string_view string, sgn::LongConstantIndex lengthConstant, std::vector<LoweredInstruction>& output); // ShitAsm Extension
+		ExternModule* FindString32Module(); // ShitAsm Extension
+
+		ExternModule* GetDependency(LoweringState& state, Symbol nameSpace);
+		std::optional<TypeReference> GetType(LoweringState& state, const Name& name);
+		std::optional<sgn::FieldIndex> GetField(LoweringState& state, const Name& name);
+		std::variant<std::monostate, sgn::FunctionIndex, sgn::MappedFunctionIndex> GetFunction(LoweringState& state, const Name& name);
+		std::optional<sgn::LabelIndex> GetLabel(LoweringState& state, Symbol name);
+		std::optional<sgn::LocalVariableIndex> GetLocalVaraible(LoweringState& state, Symbol name);
 	};
 }
\ No newline at end of file
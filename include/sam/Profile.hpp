@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sam {
+	class Profile final {
+	private:
+		std::unordered_map<std::string, std::uint64_t> m_Functions; // (Function, Execution count)
+		std::unordered_map<std::string, std::uint64_t> m_Labels; // ("<Function> <Label>", Execution count)
+		std::uint64_t m_ContentHash = 0;
+
+	public:
+		Profile() = default;
+		Profile(const Profile&) = delete;
+		~Profile() = default;
+
+	public:
+		Profile& operator=(const Profile&) = delete;
+		bool operator==(const Profile&) = delete;
+		bool operator!=(const Profile&) = delete;
+
+	public:
+		// Each line is '<Function> <Count>' or '<Function> <Label> <Count>'; ';' starts a comment.
+		// Counts of repeated entries are added, so profiles of several runs can be concatenated.
+		bool Load(const std::string& path, std::ostream& errorStream);
+
+		std::optional<std::uint64_t> GetFunctionCount(std::string_view function) const;
+		std::optional<std::uint64_t> GetLabelCount(std::string_view function, std::string_view label) const;
+		std::uint64_t GetContentHash() const noexcept;
+	};
+}
\ No newline at end of file
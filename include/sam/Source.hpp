@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace sam {
+	class Source final {
+	private:
+		std::string m_Data;
+		const char* m_MappedData = nullptr;
+		std::size_t m_MappedSize = 0;
+		std::deque<std::string> m_Texts;
+
+	public:
+		Source() noexcept = default;
+		explicit Source(std::string data) noexcept;
+		Source(const Source&) = delete;
+		~Source();
+
+	public:
+		Source& operator=(const Source&) = delete;
+		bool operator==(const Source&) = delete;
+		bool operator!=(const Source&) = delete;
+
+	public:
+		bool Open(const std::string& path);
+		bool IsMapped() const noexcept;
+
+		std::string_view GetData() const noexcept;
+		std::string_view AddText(std::string text);
+	};
+}
\ No newline at end of file
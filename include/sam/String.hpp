@@ -8,7 +8,7 @@
 namespace sam {
 	bool IsSpecial(char c) noexcept;
 
-	void Trim(std::string& string) noexcept;
+	void Trim(std::string_view& string) noexcept;
 }
 
 namespace sam {
@@ -57,7 +57,7 @@ namespace sam {
 		0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
 		0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 	};
-	constexpr std::uint32_t CRC32Internal(const char* string, std::size_t index) noexcept;
+	constexpr std::uint32_t CRC32Internal(const char* string, std::size_t length) noexcept;
 	constexpr std::uint32_t CRC32(const char* string, std::size_t length) noexcept;
 	constexpr std::uint32_t CRC32(const std::string_view& string);
 	constexpr std::uint32_t operator""_h(const char* string, std::size_t length) noexcept;
@@ -1,29 +1,35 @@
 #pragma once
 
+#include <sam/Instruction.hpp>
+#include <sam/NameIndex.hpp>
+#include <sam/SymbolTable.hpp>
 #include <sgn/Operand.hpp>
 
 #include <optional>
-#include <string>
 #include <vector>
 
 namespace sam {
 	struct Field final {
-		std::string Name;
+		Symbol Name;
 		sgn::FieldIndex Index;
+		sam::Type Type;
 	};
 }
 
 namespace sam {
 	struct Structure final {
-		std::string Name;
+		Symbol Name;
 		sgn::StructureIndex Index;
 		std::vector<Field> Fields;
 
 		std::optional<sgn::ExternStructureIndex> ExternIndex;
 		std::optional<sgn::MappedStructureIndex> MappedIndex;
 
-		std::vector<Field>::iterator FindField(const std::string& name);
-		Field& GetField(const std::string& name);
-		bool HasField(const std::string& name);
+		NameIndex FieldNames;
+
+		Field& AddField(Field field);
+		std::vector<Field>::iterator FindField(Symbol name);
+		Field& GetField(Symbol name);
+		bool HasField(Symbol name);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sam {
+	enum class Symbol : std::uint32_t {
+		Empty,
+		Entrypoint,
+	};
+}
+
+namespace sam {
+	class SymbolTable final {
+	private:
+		std::deque<std::string> m_Strings;
+		std::unordered_map<std::string_view, Symbol> m_Symbols;
+		std::unordered_map<std::uint64_t, Symbol> m_Concatenations;
+		mutable std::shared_mutex m_Mutex;
+		bool m_IsConcurrent = false; // Locks are taken only when threads share the table
+
+	public:
+		SymbolTable();
+		SymbolTable(const SymbolTable&) = delete;
+		~SymbolTable() = default;
+
+	public:
+		SymbolTable& operator=(const SymbolTable&) = delete;
+		bool operator==(const SymbolTable&) = delete;
+		bool operator!=(const SymbolTable&) = delete;
+
+	public:
+		Symbol Intern(std::string_view string);
+		Symbol Concat(Symbol prefix, Symbol suffix);
+		std::string_view GetString(Symbol symbol) const noexcept;
+		void SetConcurrent(bool isConcurrent) noexcept;
+
+	private:
+		std::shared_lock<std::shared_mutex> LockShared() const;
+		std::unique_lock<std::shared_mutex> LockUnique();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sam {
+	class ThreadPool final {
+	private:
+		struct Task final {
+			std::function<void()> Function;
+			const void* Group; // The ParallelFor call that added the task, or nullptr
+		};
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::deque<Task> m_Tasks;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_IsStopping = false;
+
+	public:
+		explicit ThreadPool(std::size_t workerCount);
+		ThreadPool(const ThreadPool&) = delete;
+		~ThreadPool();
+
+	public:
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		bool operator==(const ThreadPool&) = delete;
+		bool operator!=(const ThreadPool&) = delete;
+
+	public:
+		std::size_t GetWorkerCount() const noexcept;
+
+		void Add(std::function<void()> task);
+		void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& function);
+
+	private:
+		void Add(std::function<void()> task, const void* group);
+		void Work();
+		bool RunPendingTask(const void* group);
+	};
+}
\ No newline at end of file
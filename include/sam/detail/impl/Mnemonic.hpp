@@ -0,0 +1,59 @@
+#pragma once
+#include <sam/Mnemonic.hpp>
+
+namespace sam {
+	constexpr char ToLower(char c) noexcept {
+		return 'A' <= c && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+	}
+	constexpr std::uint32_t HashMnemonic(std::string_view mnemonic, std::uint32_t seed) noexcept {
+		std::uint32_t hash = 0x811C9DC5 ^ seed;
+		for (const char c : mnemonic) {
+			hash ^= static_cast<unsigned char>(ToLower(c));
+			hash *= 0x01000193;
+		}
+		return (hash ^ (hash >> 16)) % MnemonicTableSize;
+	}
+	constexpr MnemonicTable MakeMnemonicTable() noexcept {
+		MnemonicTable table;
+		for (;; ++table.Seed) {
+			for (auto& entry : table.Entries) {
+				entry = 0;
+			}
+
+			bool isPerfect = true;
+			for (std::size_t i = 0; i < MnemonicCount && isPerfect; ++i) {
+				auto& entry = table.Entries[HashMnemonic(Mnemonics[i].Name, table.Seed)];
+				if (entry) {
+					isPerfect = false;
+				} else {
+					entry = static_cast<std::uint8_t>(i + 1);
+				}
+			}
+			if (isPerfect) return table;
+		}
+	}
+
+	inline constexpr MnemonicTable MnemonicLookupTable = MakeMnemonicTable();
+
+	constexpr Mnemonic FindMnemonic(std::string_view mnemonic) noexcept {
+		if (mnemonic.empty() || mnemonic.size() > MnemonicMaxLength) return Mnemonic::None;
+
+		const std::uint8_t entry = MnemonicLookupTable.Entries[HashMnemonic(mnemonic, MnemonicLookupTable.Seed)];
+		if (entry == 0) return Mnemonic::None;
+
+		const MnemonicInfo& info = Mnemonics[entry - 1];
+		if (info.Name.size() != mnemonic.size()) return Mnemonic::None;
+
+		for (std::size_t i = 0; i < mnemonic.size(); ++i) {
+			if (ToLower(mnemonic[i]) != info.Name[i]) return Mnemonic::None;
+		}
+		return info.Mnemonic;
+	}
+
+	static_assert([] {
+		for (const auto& info : Mnemonics) {
+			if (info.Name.size() > MnemonicMaxLength || FindMnemonic(info.Name) != info.Mnemonic) return false;
+		}
+		return true;
+	}(), "Invalid mnemonic table");
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include <sam/NameIndex.hpp>
+
+namespace sam {
+	inline void NameIndex::Add(Symbol name, std::size_t index) {
+		m_Indices.emplace(name, index);
+	}
+	template<typename T>
+	typename std::vector<T>::iterator NameIndex::Find(std::vector<T>& elements, Symbol name) const {
+		if (const auto iter = m_Indices.find(name); iter != m_Indices.end()) return elements.begin() + iter->second;
+		else return elements.end();
+	}
+}
\ No newline at end of file
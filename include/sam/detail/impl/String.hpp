@@ -2,9 +2,12 @@
 #include <sam/String.hpp>
 
 namespace sam {
-	constexpr std::uint32_t CRC32Internal(const char* string, std::size_t index) noexcept {
-		return index == static_cast<std::size_t>(-1) ? 0xFFFFFFFF :
-			((CRC32Internal(string, index - 1) >> 8) ^ CRC32Table[(CRC32Internal(string, index - 1) ^ string[index]) & 0xFF]);
+	constexpr std::uint32_t CRC32Internal(const char* string, std::size_t length) noexcept {
+		std::uint32_t crc = 0xFFFFFFFF;
+		for (std::size_t i = 0; i < length; ++i) {
+			crc = (crc >> 8) ^ CRC32Table[(crc ^ static_cast<unsigned char>(string[i])) & 0xFF];
+		}
+		return crc;
 	}
 	constexpr std::uint32_t CRC32(const char* string, std::size_t length) noexcept {
 		return CRC32Internal(string, length) ^ 0xFFFFFFFF;
@@ -2,45 +2,50 @@
 
 #include <sam/ExternModule.hpp>
 
-#include <algorithm>
+#include <utility>
 
 namespace sam {
-	std::vector<ExternModule>::iterator Assembly::FindDependency(const std::string& path) {
-		return std::find_if(Dependencies.begin(), Dependencies.end(), [path](const ExternModule& dependency) {
-			return dependency.Path == path;
-		});
+	ExternModule& Assembly::AddDependency(ExternModule dependency) {
+		DependencyPaths.Add(dependency.Path, Dependencies.size());
+		DependencyNameSpaces.Add(dependency.NameSpace, Dependencies.size());
+		return Dependencies.emplace_back(std::move(dependency));
 	}
-	std::vector<ExternModule>::iterator Assembly::FindDependencyByNameSpace(const std::string& nameSpace) {
-		return std::find_if(Dependencies.begin(), Dependencies.end(), [nameSpace](const ExternModule& dependency) {
-			return dependency.NameSpace == nameSpace;
-		});
+	std::vector<ExternModule>::iterator Assembly::FindDependency(Symbol path) {
+		return DependencyPaths.Find(Dependencies, path);
 	}
-	ExternModule& Assembly::GetDependency(const std::string& path) {
+	std::vector<ExternModule>::iterator Assembly::FindDependencyByNameSpace(Symbol nameSpace) {
+		return DependencyNameSpaces.Find(Dependencies, nameSpace);
+	}
+	ExternModule& Assembly::GetDependency(Symbol path) {
 		return *FindDependency(path);
 	}
-	bool Assembly::HasDependency(const std::string& path) {
+	bool Assembly::HasDependency(Symbol path) {
 		return FindDependency(path) != Dependencies.end();
 	}
-	std::vector<Structure>::iterator Assembly::FindStructure(const std::string& name) {
-		return std::find_if(Structures.begin(), Structures.end(), [name](const Structure& structure) {
-			return structure.Name == name;
-		});
+	Structure& Assembly::AddStructure(Structure structure) {
+		StructureNames.Add(structure.Name, Structures.size());
+		return Structures.emplace_back(std::move(structure));
+	}
+	std::vector<Structure>::iterator Assembly::FindStructure(Symbol name) {
+		return StructureNames.Find(Structures, name);
 	}
-	Structure& Assembly::GetStructure(const std::string& name) {
+	Structure& Assembly::GetStructure(Symbol name) {
 		return *FindStructure(name);
 	}
-	bool Assembly::HasStructure(const std::string& name) {
+	bool Assembly::HasStructure(Symbol name) {
 		return FindStructure(name) != Structures.end();
 	}
-	std::vector<Function>::iterator Assembly::FindFunction(const std::string& name) {
-		return std::find_if(Functions.begin(), Functions.end(), [name](const Function& function) {
-			return function.Name == name;
-		});
+	Function& Assembly::AddFunction(Function function) {
+		FunctionNames.Add(function.Name, Functions.size());
+		return Functions.emplace_back(std::move(function));
+	}
+	std::vector<Function>::iterator Assembly::FindFunction(Symbol name) {
+		return FunctionNames.Find(Functions, name);
 	}
-	Function& Assembly::GetFunction(const std::string& name) {
+	Function& Assembly::GetFunction(Symbol name) {
 		return *FindFunction(name);
 	}
-	bool Assembly::HasFunction(const std::string& name) {
+	bool Assembly::HasFunction(Symbol name) {
 		return FindFunction(name) != Functions.end();
 	}
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <sam/BuildRecord.hpp>
+
+#include <sam/ExternModule.hpp>
+#include <sam/ModuleCache.hpp>
+#include <sam/Source.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <ios>
+#include <sstream>
+#include <utility>
+
+namespace sam {
+	namespace {
+		constexpr char Header[] = "ShitAsm build record 1";
+
+		void WriteDepfilePath(std::ostream& stream, const std::string& path) {
+			for (const char c : path) {
+				if (c == ' ' || c == '#') {
+					stream << '\\';
+				} else if (c == '$') {
+					stream << '$';
+				}
+				stream << c;
+			}
+		}
+	}
+
+	void BuildRecord::AddInput(std::string path, std::uint64_t contentHash) {
+		const auto iter = std::find_if(Inputs.begin(), Inputs.end(), [&path](const Input& input) {
+			return input.Path == path;
+		});
+		if (iter == Inputs.end()) {
+			Inputs.push_back({ std::move(path), contentHash });
+		}
+	}
+	void BuildRecord::AddInputs(const Assembly& assembly) {
+		for (const auto& dependency : assembly.Dependencies) {
+			AddInput(dependency.SourcePath, dependency.ContentHash);
+			AddInputs(dependency.Assembly);
+		}
+	}
+	bool BuildRecord::IsUpToDate() const {
+		for (const auto& input : Inputs) {
+			Source source;
+			if (!source.Open(input.Path) || ModuleCache::Hash(source.GetData()) != input.ContentHash) return false;
+		}
+		return !Inputs.empty();
+	}
+
+	std::optional<BuildRecord> BuildRecord::Load(const std::string& path) {
+		std::ifstream stream(path);
+		std::string line;
+		if (!stream || !std::getline(stream, line) || line != Header) return std::nullopt;
+
+		BuildRecord result;
+		if (!(stream >> std::hex >> result.OptionHash) || !std::getline(stream, line) || !line.empty()) return std::nullopt;
+
+		while (std::getline(stream, line)) {
+			std::istringstream lineStream(line);
+			Input& input = result.Inputs.emplace_back();
+			if (!(lineStream >> std::hex >> input.ContentHash) || lineStream.get() != ' ' ||
+				!std::getline(lineStream, input.Path) || input.Path.empty()) return std::nullopt;
+		}
+		return result;
+	}
+	bool BuildRecord::Store(const std::string& path) const {
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream) return false;
+
+		stream << Header << '\n' << std::hex << OptionHash << '\n';
+		for (const auto& input : Inputs) {
+			stream << input.ContentHash << ' ' << input.Path << '\n';
+		}
+		return static_cast<bool>(stream);
+	}
+	bool BuildRecord::WriteDepfile(const std::string& path, const std::string& target) const {
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream) return false;
+
+		WriteDepfilePath(stream, target);
+		stream << ':';
+		for (const auto& input : Inputs) {
+			stream << " \\\n  ";
+			WriteDepfilePath(stream, input.Path);
+		}
+		stream << '\n';
+		return static_cast<bool>(stream);
+	}
+}
\ No newline at end of file
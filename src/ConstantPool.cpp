@@ -0,0 +1,115 @@
+#include <sam/ConstantPool.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <variant>
+
+namespace sam {
+	std::uint32_t ConstantPool::Table::Add(std::uint64_t bits, std::size_t referenceCount) {
+		const auto [iter, isAdded] = Indices.try_emplace(bits, static_cast<std::uint32_t>(Constants.size()));
+		if (isAdded) {
+			Constants.push_back({ bits, referenceCount });
+		} else {
+			Constants[iter->second].ReferenceCount += referenceCount;
+		}
+		return iter->second;
+	}
+	std::uint32_t ConstantPool::Table::Relocate(std::uint32_t index) const {
+		return Relocations[index];
+	}
+
+	sgn::IntConstantIndex ConstantPool::AddIntConstant(std::uint32_t value) {
+		++m_ReferenceCount;
+		return static_cast<sgn::IntConstantIndex>(m_Ints.Add(value));
+	}
+	sgn::LongConstantIndex ConstantPool::AddLongConstant(std::uint64_t value) {
+		++m_ReferenceCount;
+		return static_cast<sgn::LongConstantIndex>(m_Longs.Add(value));
+	}
+	sgn::SingleConstantIndex ConstantPool::AddSingleConstant(float value) {
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		++m_ReferenceCount;
+		return static_cast<sgn::SingleConstantIndex>(m_Singles.Add(bits));
+	}
+	sgn::DoubleConstantIndex ConstantPool::AddDoubleConstant(double value) {
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		++m_ReferenceCount;
+		return static_cast<sgn::DoubleConstantIndex>(m_Doubles.Add(bits));
+	}
+
+	void ConstantPool::Merge(ConstantPool& pool) {
+		// Relocate of the merged pool then turns its indices into the ones of this pool
+		const auto merge = [](Table& table, Table& other) {
+			other.Relocations.resize(other.Constants.size());
+			for (std::size_t i = 0; i < other.Constants.size(); ++i) {
+				other.Relocations[i] = table.Add(other.Constants[i].Bits, other.Constants[i].ReferenceCount);
+			}
+		};
+
+		merge(m_Ints, pool.m_Ints);
+		merge(m_Longs, pool.m_Longs);
+		merge(m_Singles, pool.m_Singles);
+		merge(m_Doubles, pool.m_Doubles);
+		m_ReferenceCount += pool.m_ReferenceCount;
+	}
+	void ConstantPool::Generate(sgn::ByteFile& byteFile) {
+		// Most referenced constants first, so that hot constants share cache lines in the VM
+		const auto generate = [](Table& table, auto&& add) {
+			std::vector<std::uint32_t> order(table.Constants.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&table](std::uint32_t a, std::uint32_t b) {
+				return table.Constants[a].ReferenceCount > table.Constants[b].ReferenceCount;
+			});
+
+			table.Relocations.resize(table.Constants.size());
+			for (const std::uint32_t index : order) {
+				table.Relocations[index] = static_cast<std::uint32_t>(add(table.Constants[index].Bits));
+			}
+		};
+
+		generate(m_Ints, [&byteFile](std::uint64_t bits) {
+			return byteFile.AddIntConstant(static_cast<std::uint32_t>(bits));
+		});
+		generate(m_Longs, [&byteFile](std::uint64_t bits) {
+			return byteFile.AddLongConstant(bits);
+		});
+		generate(m_Singles, [&byteFile](std::uint64_t bits) {
+			const auto singleBits = static_cast<std::uint32_t>(bits);
+			float value;
+			std::memcpy(&value, &singleBits, sizeof(value));
+			return byteFile.AddSingleConstant(value);
+		});
+		generate(m_Doubles, [&byteFile](std::uint64_t bits) {
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return byteFile.AddDoubleConstant(value);
+		});
+	}
+	void ConstantPool::Relocate(std::vector<LoweredInstruction>& instructions) const {
+		for (auto& [mnemonic, operand] : instructions) {
+			if (mnemonic != Mnemonic::Push) continue;
+
+			if (const auto index = std::get_if<sgn::IntConstantIndex>(&operand)) {
+				*index = static_cast<sgn::IntConstantIndex>(m_Ints.Relocate(static_cast<std::uint32_t>(*index)));
+			} else if (const auto index = std::get_if<sgn::LongConstantIndex>(&operand)) {
+				*index = static_cast<sgn::LongConstantIndex>(m_Longs.Relocate(static_cast<std::uint32_t>(*index)));
+			} else if (const auto index = std::get_if<sgn::SingleConstantIndex>(&operand)) {
+				*index = static_cast<sgn::SingleConstantIndex>(m_Singles.Relocate(static_cast<std::uint32_t>(*index)));
+			} else if (const auto index = std::get_if<sgn::DoubleConstantIndex>(&operand)) {
+				*index = static_cast<sgn::DoubleConstantIndex>(m_Doubles.Relocate(static_cast<std::uint32_t>(*index)));
+			}
+		}
+	}
+
+	std::size_t ConstantPool::GetReferenceCount() const noexcept {
+		return m_ReferenceCount;
+	}
+	std::size_t ConstantPool::GetConstantCount() const noexcept {
+		return m_Ints.Constants.size() + m_Longs.Constants.size() + m_Singles.Constants.size() + m_Doubles.Constants.size();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <sam/Context.hpp>
+
+#include <algorithm>
+
+namespace sam {
+	void Statistics::AddInput(const Source& source, std::chrono::nanoseconds readTime, std::chrono::nanoseconds lexTime) {
+		std::lock_guard lock(Mutex);
+		++InputFiles;
+		MappedInputFiles += source.IsMapped();
+		InputBytes += source.GetData().size();
+		ReadTime += readTime;
+		LexTime += lexTime;
+	}
+	void Statistics::AddCachedModule() {
+		std::lock_guard lock(Mutex);
+		++CachedModules;
+	}
+	void Statistics::AddReusedModule() {
+		std::lock_guard lock(Mutex);
+		++ReusedModules;
+	}
+	void Statistics::AddSkippedOutput() {
+		std::lock_guard lock(Mutex);
+		++SkippedOutputs;
+	}
+	void Statistics::AddEliminatedInstructions(std::size_t count) {
+		std::lock_guard lock(Mutex);
+		EliminatedInstructions += count;
+	}
+	void Statistics::AddInlinedCalls(std::size_t count) {
+		std::lock_guard lock(Mutex);
+		InlinedCalls += count;
+	}
+	void Statistics::AddEliminatedTailCalls(std::size_t count) {
+		std::lock_guard lock(Mutex);
+		EliminatedTailCalls += count;
+	}
+	void Statistics::AddSharedLocalVariables(std::size_t count) {
+		std::lock_guard lock(Mutex);
+		SharedLocalVariables += count;
+	}
+	void Statistics::AddRemovedSections(std::size_t functionCount, std::size_t structureCount) {
+		std::lock_guard lock(Mutex);
+		RemovedFunctions += functionCount;
+		RemovedStructures += structureCount;
+	}
+	void Statistics::AddVerifiedFunction(std::size_t maxStackDepth) {
+		std::lock_guard lock(Mutex);
+		++VerifiedFunctions;
+		MaxStackDepth = std::max(MaxStackDepth, maxStackDepth);
+	}
+	void Statistics::AddConstants(std::size_t referenceCount, std::size_t constantCount) {
+		std::lock_guard lock(Mutex);
+		ConstantReferences += referenceCount;
+		Constants += constantCount;
+	}
+}
\ No newline at end of file
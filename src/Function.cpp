@@ -1,28 +1,32 @@
 #include <sam/Function.hpp>
 
-#include <algorithm>
+#include <utility>
 
 namespace sam {
-	std::vector<Label>::iterator Function::FindLabel(const std::string& name) {
-		return std::find_if(Labels.begin(), Labels.end(), [name](const Label& label) {
-			return label.Name == name;
-		});
+	Label& Function::AddLabel(Label label) {
+		LabelNames.Add(label.Name, Labels.size());
+		return Labels.emplace_back(std::move(label));
 	}
-	Label& Function::GetLabel(const std::string& name) {
+	std::vector<Label>::iterator Function::FindLabel(Symbol name) {
+		return LabelNames.Find(Labels, name);
+	}
+	Label& Function::GetLabel(Symbol name) {
 		return *FindLabel(name);
 	}
-	bool Function::HasLabel(const std::string& name) {
+	bool Function::HasLabel(Symbol name) {
 		return FindLabel(name) != Labels.end();
 	}
-	std::vector<LocalVariable>::iterator Function::FindLocalVariable(const std::string& name) {
-		return std::find_if(LocalVariables.begin(), LocalVariables.end(), [name](const LocalVariable& var) {
-			return var.Name == name;
-		});
+	LocalVariable& Function::AddLocalVariable(LocalVariable localVariable) {
+		LocalVariableNames.Add(localVariable.Name, LocalVariables.size());
+		return LocalVariables.emplace_back(std::move(localVariable));
+	}
+	std::vector<LocalVariable>::iterator Function::FindLocalVariable(Symbol name) {
+		return LocalVariableNames.Find(LocalVariables, name);
 	}
-	LocalVariable& Function::GetLocalVariable(const std::string& name) {
+	LocalVariable& Function::GetLocalVariable(Symbol name) {
 		return *FindLocalVariable(name);
 	}
-	bool Function::HasLocalVariable(const std::string& name) {
+	bool Function::HasLocalVariable(Symbol name) {
 		return FindLocalVariable(name) != LocalVariables.end();
 	}
 }
\ No newline at end of file
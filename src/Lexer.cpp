@@ -8,12 +8,16 @@
 #include <utility>
 
 namespace sam {
-	Token::Token(std::string word, TokenType type, std::size_t line) noexcept
-		: Word(std::move(word)), Type(type), Line(line) {}
-	Token::Token(std::string word, TokenData data, TokenType type, std::size_t line) noexcept
-		: Word(std::move(word)), Type(type), Data(std::move(data)), Line(line) {}
-	Token::Token(std::string word, std::string suffix, TokenData data, TokenType type, std::size_t line) noexcept
-		: Word(std::move(word)), Suffix(std::move(suffix)), Data(std::move(data)), Type(type), Line(line) {}
+	Token::Token(std::string_view word, TokenType type, std::size_t line) noexcept
+		: Word(word), Line(static_cast<std::uint32_t>(line)), Type(type) {}
+	Token::Token(std::string_view word, TokenData data, TokenType type, std::size_t line) noexcept
+		: Word(word), Data(data), Line(static_cast<std::uint32_t>(line)), Type(type) {}
+	Token::Token(std::string_view word, std::string_view suffix, TokenData data, TokenType type, std::size_t line) noexcept
+		: Word(word), Data(data), Line(static_cast<std::uint32_t>(line)), Type(type), SuffixSize(static_cast<std::uint8_t>(suffix.size())) {}
+
+	std::string_view Token::GetSuffix() const noexcept {
+		return Word.substr(Word.size() - SuffixSize);
+	}
 
 	std::ostream& operator<<(std::ostream& stream, const Token& token) {
 		static constexpr std::string_view tokenTypes[] = {
@@ -37,12 +41,14 @@ namespace sam {
 				stream << std::get<std::uint64_t>(token.Data);
 			} else if (std::holds_alternative<double>(token.Data)) {
 				stream << std::get<double>(token.Data);
-			} else if (std::holds_alternative<std::string>(token.Data)) {
-				stream << '"' << std::get<std::string>(token.Data) << '"';
+			} else if (std::holds_alternative<std::string_view>(token.Data)) {
+				stream << '"' << std::get<std::string_view>(token.Data) << '"';
+			} else if (std::holds_alternative<Symbol>(token.Data)) {
+				stream << "Symbol #" << static_cast<std::uint32_t>(std::get<Symbol>(token.Data));
 			}
 		}
-		if (!token.Suffix.empty()) {
-			stream << "\n\tSuffix: \"" << token.Suffix << '"';
+		if (token.SuffixSize) {
+			stream << "\n\tSuffix: \"" << token.GetSuffix() << '"';
 		}
 
 		return stream;
@@ -50,8 +56,8 @@ namespace sam {
 }
 
 namespace sam {
-	Lexer::Lexer(std::string path, std::istream& inputStream) noexcept
-		: m_Path(std::move(path)), m_InputStream(inputStream) {}
+	Lexer::Lexer(std::string path, std::shared_ptr<Source> source, SymbolTable& symbols) noexcept
+		: m_Path(std::move(path)), m_Source(std::move(source)), m_Symbols(symbols) {}
 
 #define MESSAGEBASE m_ErrorStream << "In file '" << m_Path << "':\n    "
 #define INFO (m_HasInfo = true, MESSAGEBASE) << "Info: Line " << m_LineNum << ", "
@@ -59,7 +65,15 @@ namespace sam {
 #define ERROR (m_HasError = true, MESSAGEBASE) << "Error: Line " << m_LineNum << ", "
 
 	void Lexer::Lex() {
-		while (std::getline(m_InputStream, m_Line) && ++m_LineNum) {
+		const std::string_view data = m_Source->GetData();
+		for (std::size_t lineBegin = 0; lineBegin < data.size() && ++m_LineNum;) {
+			std::size_t lineEnd = data.find('\n', lineBegin);
+			if (lineEnd == std::string_view::npos) {
+				lineEnd = data.size();
+			}
+
+			m_Line = data.substr(lineBegin, lineEnd - lineBegin);
+			lineBegin = lineEnd + 1;
 			if (IgnoreComment()) continue;
 
 			for (m_Column = 0; m_Column < m_Line.size();) {
@@ -81,6 +95,9 @@ namespace sam {
 	std::vector<Token> Lexer::GetTokens() noexcept {
 		return std::move(m_Result);
 	}
+	std::shared_ptr<const Source> Lexer::GetSource() const noexcept {
+		return m_Source;
+	}
 
 	bool Lexer::HasError() const noexcept {
 		return m_HasError;
@@ -93,8 +110,8 @@ namespace sam {
 	}
 
 	bool Lexer::IgnoreComment() noexcept {
-		if (const auto commentBegin = m_Line.find(';'); commentBegin != std::string::npos) {
-			m_Line.erase(m_Line.begin() + commentBegin, m_Line.end());
+		if (const auto commentBegin = m_Line.find(';'); commentBegin != std::string_view::npos) {
+			m_Line = m_Line.substr(0, commentBegin);
 		}
 
 		Trim(m_Line);
@@ -108,7 +125,7 @@ namespace sam {
 	void Lexer::LexSpecial() {
 		const char firstByte = GetByte(m_Column++);
 		switch (firstByte) {
-#define CASE(e, c) case c: m_Result.emplace_back(std::string(1, c), TokenType:: e, m_LineNum); break
+#define CASE(e, c) case c: m_Result.emplace_back(m_Line.substr(m_Column - 1, 1), TokenType:: e, m_LineNum); break
 		CASE(Plus, '+');
 		CASE(Minus, '-');
 
@@ -200,7 +217,7 @@ namespace sam {
 
 		const std::uint64_t value = std::stoull(digits, nullptr, base);
 		const std::string_view suffix = literal.substr(digitEnd);
-		m_Result.emplace_back(std::string(literal), std::string(suffix), value, type, m_LineNum);
+		m_Result.emplace_back(literal, suffix, value, type, m_LineNum);
 	}
 	void Lexer::LexBinInteger(std::string_view& literal) {
 		LexInteger(literal, 2, TokenType::BinInteger, 2, [](char c) noexcept {
@@ -255,11 +272,12 @@ namespace sam {
 
 		const double value = std::stod(digits);
 		const std::string_view suffix = literal.substr(digitEnd);
-		m_Result.emplace_back(std::string(literal), std::string(suffix), value, TokenType::Decimal, m_LineNum);
+		m_Result.emplace_back(literal, suffix, value, TokenType::Decimal, m_LineNum);
 	}
 
 	void Lexer::LexText(char firstByte) {
 		std::string text;
+		bool hasEscape = false;
 		std::size_t textEnd = m_Column + 1;
 		while (true) {
 			const char byte = GetByte(textEnd++);
@@ -275,6 +293,7 @@ namespace sam {
 					return;
 				} else if (nextByte == firstByte) {
 					text.push_back(firstByte);
+					hasEscape = true;
 				} else {
 					ERROR << "Invalid escape sequence '\\" << nextByte << "'.\n";
 					m_Column = static_cast<std::size_t>(-1);
@@ -286,8 +305,10 @@ namespace sam {
 			}
 		}
 
-		m_Result.emplace_back(m_Line.substr(m_Column, textEnd + 1), text, firstByte == '"' ? TokenType::String : TokenType::Character, m_LineNum);
-		m_Column = textEnd + 1;
+		const std::string_view word = m_Line.substr(m_Column, textEnd - m_Column);
+		const std::string_view data = hasEscape ? m_Source->AddText(std::move(text)) : word.substr(1, word.size() - 2);
+		m_Result.emplace_back(word, data, firstByte == '"' ? TokenType::String : TokenType::Character, m_LineNum);
+		m_Column = textEnd;
 	}
 
 	void Lexer::LexIdentifier() {
@@ -298,11 +319,11 @@ namespace sam {
 			++end;
 		}
 
-		const std::string identifier = m_Line.substr(m_Column, end - m_Column);
-		m_Result.emplace_back(identifier, identifier, TokenType::Identifier, m_LineNum);
+		const std::string_view identifier = m_Line.substr(m_Column, end - m_Column);
+		m_Result.emplace_back(identifier, m_Symbols.Intern(identifier), TokenType::Identifier, m_LineNum);
 		m_Column += identifier.size();
 
-		static const std::unordered_map<std::string, TokenType> keywords = {
+		static const std::unordered_map<std::string_view, TokenType> keywords = {
 			{ "import", TokenType::ImportKeyword },
 			{ "as", TokenType::AsKeyword },
 			{ "struct", TokenType::StructKeyword },
@@ -1,66 +1,120 @@
 #include <sam/Assembly.hpp>
+#include <sam/BuildRecord.hpp>
+#include <sam/Context.hpp>
 #include <sam/ExternModule.hpp>
 #include <sam/Lexer.hpp>
+#include <sam/ModuleCache.hpp>
 #include <sam/Parser.hpp>
+#include <sam/Profile.hpp>
+#include <sam/Source.hpp>
+#include <sam/ThreadPool.hpp>
 #include <sgn/Generator.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
 struct ProgramOption {
-	const char* Input = nullptr;
+	std::vector<std::string> Inputs;
 	const char* Output = nullptr;
 	std::vector<const char*> ImportDirectories;
+	bool UseMultiPass = false;
+	unsigned OptimizationLevel = 0;
+	bool UseGcSections = false;
+	bool UseStaticLinking = false;
+	const char* ProfilePath = nullptr;
+	unsigned ThreadCount = 1;
+	const char* ModuleCacheDirectory = nullptr;
+	bool IsIncremental = false;
+	bool WriteDepfile = false;
+	bool IsServer = false;
+	bool ShowStatistics = false;
 };
 
 void PrintUsage();
 bool ParseProgramOption(int argc, char* argv[], ProgramOption& programOption);
+bool ReadResponseFile(const char* path, std::vector<std::string>& inputs);
+std::uint64_t GetOptionHash(const ProgramOption& programOption);
+bool Assemble(sam::Context& context, const ProgramOption& programOption, const std::string& input, const std::string& output, std::ostream& messageStream);
+void RunServer(sam::Context& context, const ProgramOption& programOption);
+void PrintStatistics(const sam::Statistics& statistics);
 
 int main(int argc, char* argv[]) {
 	ProgramOption programOption;
 	if (!ParseProgramOption(argc, argv, programOption)) return EXIT_FAILURE;
 
-	const std::string input = programOption.Input;
-	std::ifstream inputStream(input);
-	if (!inputStream) {
-		std::cout << "Error: Failed to open '" << input << "'.\n";
-		return EXIT_FAILURE;
+	sam::Context context;
+	context.ImportDirectories = programOption.ImportDirectories;
+	context.UseMultiPass = programOption.UseMultiPass;
+	context.OptimizationLevel = programOption.OptimizationLevel;
+	context.UseGcSections = programOption.UseGcSections;
+	context.UseStaticLinking = programOption.UseStaticLinking;
+	if (programOption.ThreadCount > 1) {
+		context.ThreadPool = std::make_unique<sam::ThreadPool>(programOption.ThreadCount - 1);
+		context.Symbols.SetConcurrent(true);
 	}
-
-	sam::Lexer lexer(input, inputStream);
-	lexer.Lex();
-	if (lexer.HasMessage()) {
-		std::cout << lexer.GetMessages();
-		if (lexer.HasError()) return EXIT_FAILURE;
+	if (programOption.ModuleCacheDirectory) {
+		context.ModuleCache = std::make_unique<sam::ModuleCache>(programOption.ModuleCacheDirectory);
 	}
-
-	sam::Parser parser(programOption.ImportDirectories, input, lexer.GetTokens(), false);
-	parser.Parse();
-	if (parser.HasMessage()) {
-		std::cout << parser.GetMessages();
-		if (parser.HasError()) return EXIT_FAILURE;
+	if (programOption.ProfilePath) {
+		context.Profile = std::make_unique<sam::Profile>();
+		if (!context.Profile->Load(programOption.ProfilePath, std::cout)) return EXIT_FAILURE;
 	}
 
-	std::string output;
-	if (programOption.Output) {
-		output = programOption.Output;
+	bool isSucceeded = true;
+	if (programOption.IsServer) {
+		RunServer(context, programOption);
+	} else if (programOption.Inputs.size() == 1) {
+		const std::string& input = programOption.Inputs.front();
+		std::string output;
+		if (programOption.Output) {
+			output = programOption.Output;
+		} else {
+			output = std::filesystem::path(input).replace_extension(".sbf").string();
+		}
+
+		isSucceeded = Assemble(context, programOption, input, output, std::cout);
 	} else {
-		output = std::filesystem::path(input).replace_extension(".sbf").string();
+		std::vector<std::ostringstream> messageStreams(programOption.Inputs.size());
+		std::vector<char> results(programOption.Inputs.size());
+		const auto assemble = [&](std::size_t i) {
+			const std::string& input = programOption.Inputs[i];
+			results[i] = Assemble(context, programOption, input, std::filesystem::path(input).replace_extension(".sbf").string(), messageStreams[i]);
+		};
+
+		if (context.ThreadPool) {
+			context.ThreadPool->ParallelFor(programOption.Inputs.size(), assemble);
+		} else {
+			for (std::size_t i = 0; i < programOption.Inputs.size(); ++i) {
+				assemble(i);
+			}
+		}
+
+		for (std::size_t i = 0; i < programOption.Inputs.size(); ++i) {
+			std::cout << messageStreams[i].str();
+			isSucceeded &= static_cast<bool>(results[i]);
+		}
 	}
 
-	const sam::Assembly assembly = parser.GetAssembly();
-	sgn::Generator generator(assembly.ByteFile);
-	generator.Generate(output);
+	if (isSucceeded && programOption.ShowStatistics) {
+		PrintStatistics(context.Statistics);
+	}
 
-	return EXIT_SUCCESS;
+	return isSucceeded ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 void PrintUsage() {
-	std::cout << "Usage: ./ShitAsm <Input> [-o Output] [-I Import Directory]...\n";
+	std::cout << "Usage: ./ShitAsm <Input|@Response File>...|--server [-o Output] [-I Import Directory]... [--multi-pass] [-O0|-O1] [--gc-sections] [--static] [--profile File] [-j Thread Count] [--module-cache Directory] [--incremental] [--depfile] [--stats]\n";
 }
 bool ParseProgramOption(int argc, char* argv[], ProgramOption& programOption) {
 	if (argc == 1) return PrintUsage(), false;
@@ -72,11 +126,209 @@ bool ParseProgramOption(int argc, char* argv[], ProgramOption& programOption) {
 		} else if (std::strcmp(argv[i], "-I") == 0) {
 			if (i == argc) return PrintUsage(), false;
 			programOption.ImportDirectories.push_back(argv[++i]);
+		} else if (std::strcmp(argv[i], "--multi-pass") == 0) {
+			programOption.UseMultiPass = true;
+		} else if (std::strcmp(argv[i], "-O0") == 0) {
+			programOption.OptimizationLevel = 0;
+		} else if (std::strcmp(argv[i], "-O1") == 0) {
+			programOption.OptimizationLevel = 1;
+		} else if (std::strcmp(argv[i], "--gc-sections") == 0) {
+			programOption.UseGcSections = true;
+		} else if (std::strcmp(argv[i], "--static") == 0) {
+			programOption.UseStaticLinking = true;
+		} else if (std::strcmp(argv[i], "--profile") == 0) {
+			if (i == argc || programOption.ProfilePath) return PrintUsage(), false;
+			programOption.ProfilePath = argv[++i];
+		} else if (std::strcmp(argv[i], "-j") == 0) {
+			if (i == argc) return PrintUsage(), false;
+			programOption.ThreadCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			if (programOption.ThreadCount == 0) {
+				programOption.ThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+		} else if (std::strcmp(argv[i], "--module-cache") == 0) {
+			if (i == argc || programOption.ModuleCacheDirectory) return PrintUsage(), false;
+			programOption.ModuleCacheDirectory = argv[++i];
+		} else if (std::strcmp(argv[i], "--incremental") == 0) {
+			programOption.IsIncremental = true;
+		} else if (std::strcmp(argv[i], "--depfile") == 0) {
+			programOption.WriteDepfile = true;
+		} else if (std::strcmp(argv[i], "--server") == 0) {
+			programOption.IsServer = true;
+		} else if (std::strcmp(argv[i], "--stats") == 0) {
+			programOption.ShowStatistics = true;
+		} else if (argv[i][0] == '@') {
+			if (!ReadResponseFile(argv[i] + 1, programOption.Inputs)) return false;
 		} else {
-			if (programOption.Input) return PrintUsage(), false;
-			programOption.Input = argv[i];
+			programOption.Inputs.push_back(argv[i]);
+		}
+	}
+
+	if (programOption.IsServer) {
+		if (programOption.Inputs.empty() && !programOption.Output) return true;
+
+		std::cout << "Error: '--server' cannot be used with inputs or '-o'.\n";
+		return false;
+	} else if (programOption.Inputs.empty()) return PrintUsage(), false;
+	else if (programOption.Inputs.size() > 1 && programOption.Output) {
+		std::cout << "Error: '-o' cannot be used with multiple inputs.\n";
+		return false;
+	}
+	return true;
+}
+bool ReadResponseFile(const char* path, std::vector<std::string>& inputs) {
+	std::ifstream stream(path);
+	if (!stream) {
+		std::cout << "Error: Failed to open '" << path << "'.\n";
+		return false;
+	}
+
+	for (std::string line; std::getline(stream, line);) {
+		const std::size_t begin = line.find_first_not_of(" \t\r");
+		if (begin == std::string::npos) continue;
+
+		const std::size_t end = line.find_last_not_of(" \t\r");
+		inputs.push_back(line.substr(begin, end - begin + 1));
+	}
+	return true;
+}
+std::uint64_t GetOptionHash(const ProgramOption& programOption) {
+	// Options that change how imports resolve or what is generated
+	std::string options;
+	for (const char* directory : programOption.ImportDirectories) {
+		options.append("-I").append(directory).push_back('\n');
+	}
+	options.append("-O").append(std::to_string(programOption.OptimizationLevel)).push_back('\n');
+	if (programOption.UseGcSections) {
+		options.append("--gc-sections\n");
+	}
+	if (programOption.UseStaticLinking) {
+		options.append("--static\n");
+	}
+	if (programOption.ProfilePath) {
+		options.append("--profile\n");
+	}
+	return sam::ModuleCache::Hash(options);
+}
+bool Assemble(sam::Context& context, const ProgramOption& programOption, const std::string& input, const std::string& output, std::ostream& messageStream) {
+	const std::string recordPath = output + ".sbr";
+	const std::uint64_t optionHash = GetOptionHash(programOption);
+	if (programOption.IsIncremental && std::filesystem::exists(output)) {
+		const auto record = sam::BuildRecord::Load(recordPath);
+		if (record && record->OptionHash == optionHash && record->IsUpToDate() && record->Inputs.front().Path == input) {
+			context.Statistics.AddSkippedOutput();
+			return true;
+		}
+	}
+
+	const auto readBegin = std::chrono::steady_clock::now();
+	const auto source = std::make_shared<sam::Source>();
+	if (!source->Open(input)) {
+		messageStream << "Error: Failed to open '" << input << "'.\n";
+		return false;
+	}
+
+	const auto lexBegin = std::chrono::steady_clock::now();
+	sam::Lexer lexer(input, source, context.Symbols);
+	lexer.Lex();
+	context.Statistics.AddInput(*source, lexBegin - readBegin, std::chrono::steady_clock::now() - lexBegin);
+	if (lexer.HasMessage()) {
+		messageStream << lexer.GetMessages();
+		if (lexer.HasError()) return false;
+	}
+
+	sam::Parser parser(context, input, lexer.GetSource(), lexer.GetTokens(), false);
+	parser.Parse();
+	if (parser.HasMessage()) {
+		messageStream << parser.GetMessages();
+		if (parser.HasError()) return false;
+	}
+
+	const sam::Assembly assembly = parser.GetAssembly();
+	sgn::Generator generator(assembly.ByteFile);
+	generator.Generate(output);
+
+	if (programOption.IsIncremental || programOption.WriteDepfile) {
+		sam::BuildRecord record;
+		record.OptionHash = optionHash;
+		record.AddInput(input, sam::ModuleCache::Hash(source->GetData()));
+		if (context.Profile) {
+			record.AddInput(programOption.ProfilePath, context.Profile->GetContentHash());
+		}
+		record.AddInputs(assembly);
+
+		if (programOption.IsIncremental && !record.Store(recordPath)) {
+			messageStream << "Warning: Failed to write '" << recordPath << "'.\n";
+		}
+		if (programOption.WriteDepfile && !record.WriteDepfile(output + ".d", output)) {
+			messageStream << "Warning: Failed to write '" << output << ".d'.\n";
 		}
 	}
+	return true;
+}
+void RunServer(sam::Context& context, const ProgramOption& programOption) {
+	// Request: <Input>[\t<Output>]
+	// Response: ok|error <Line Count>, followed by that many lines of messages
+	for (std::string request; std::getline(std::cin, request);) {
+		if (!request.empty() && request.back() == '\r') {
+			request.pop_back();
+		}
+		if (request.empty()) continue;
+
+		const std::size_t tab = request.find('\t');
+		const std::string input = request.substr(0, tab);
+		const std::string output = tab != std::string::npos ? request.substr(tab + 1) :
+			std::filesystem::path(input).replace_extension(".sbf").string();
+
+		context.Modules.Revalidate();
 
-	return programOption.Input != nullptr;
+		std::ostringstream messageStream;
+		const bool isSucceeded = Assemble(context, programOption, input, output, messageStream);
+		const std::string messages = messageStream.str();
+		std::cout << (isSucceeded ? "ok " : "error ") << std::count(messages.begin(), messages.end(), '\n') << '\n'
+			<< messages << std::flush;
+	}
+}
+void PrintStatistics(const sam::Statistics& statistics) {
+	const double readTime = std::chrono::duration<double>(statistics.ReadTime).count();
+	const double lexTime = std::chrono::duration<double>(statistics.LexTime).count();
+	const double inputTime = readTime + lexTime;
+
+	std::cout << "Statistics:\n"
+		<< "    Input: " << statistics.InputFiles << " file(s) (" << statistics.MappedInputFiles << " memory-mapped), "
+		<< statistics.InputBytes << " byte(s)\n"
+		<< "    Read: " << readTime * 1000 << "ms, Lex: " << lexTime * 1000 << "ms, "
+		<< (inputTime > 0 ? statistics.InputBytes / inputTime : 0) << " byte(s)/s\n";
+	if (statistics.ReusedModules > 0) {
+		std::cout << "    Imports: " << statistics.ReusedModules << " module(s) reused without parsing again\n";
+	}
+	if (statistics.InlinedCalls > 0) {
+		std::cout << "    Inliner: " << statistics.InlinedCalls << " call(s) inlined\n";
+	}
+	if (statistics.EliminatedTailCalls > 0) {
+		std::cout << "    Tail calls: " << statistics.EliminatedTailCalls << " self call(s) turned into jumps\n";
+	}
+	if (statistics.SharedLocalVariables > 0) {
+		std::cout << "    Local variables: " << statistics.SharedLocalVariables << " merged into slots of others\n";
+	}
+	if (statistics.EliminatedInstructions > 0) {
+		std::cout << "    Optimizer: " << statistics.EliminatedInstructions << " instruction(s) eliminated\n";
+	}
+	if (statistics.RemovedFunctions > 0 || statistics.RemovedStructures > 0) {
+		std::cout << "    Unused sections: " << statistics.RemovedFunctions << " function(s) and "
+			<< statistics.RemovedStructures << " structure(s) removed\n";
+	}
+	if (statistics.VerifiedFunctions > 0) {
+		std::cout << "    Stack: " << statistics.VerifiedFunctions << " function(s) verified, up to "
+			<< statistics.MaxStackDepth << " value(s) deep\n";
+	}
+	if (statistics.ConstantReferences > 0) {
+		std::cout << "    Constant pool: " << statistics.ConstantReferences << " constant(s) before deduplication, "
+			<< statistics.Constants << " after\n";
+	}
+	if (statistics.SkippedOutputs > 0) {
+		std::cout << "    Up to date: " << statistics.SkippedOutputs << " output(s) skipped\n";
+	}
+	if (statistics.CachedModules > 0) {
+		std::cout << "    Module cache: " << statistics.CachedModules << " module(s) loaded from cache\n";
+	}
 }
\ No newline at end of file
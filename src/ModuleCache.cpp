@@ -0,0 +1,223 @@
+#include <sam/ModuleCache.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace sam {
+	namespace {
+		constexpr char Magic[4] = { 'S', 'A', 'M', 'I' };
+		constexpr std::uint32_t Version = 2;
+
+		class Writer final {
+		public:
+			std::string Data;
+
+		public:
+			void Write(std::uint64_t value) {
+				for (int i = 0; i < 8; ++i) {
+					Data.push_back(static_cast<char>(value >> (i * 8)));
+				}
+			}
+			void Write(std::string_view string) {
+				Write(static_cast<std::uint64_t>(string.size()));
+				Data.append(string);
+			}
+		};
+
+		class Reader final {
+		private:
+			std::string_view m_Data;
+			bool m_HasError = false;
+
+		public:
+			explicit Reader(std::string_view data) noexcept
+				: m_Data(data) {}
+
+		public:
+			bool HasError() const noexcept {
+				return m_HasError || !m_Data.empty();
+			}
+
+			std::uint64_t ReadInteger() noexcept {
+				if (m_Data.size() < 8) return m_HasError = true, 0;
+
+				std::uint64_t value = 0;
+				for (int i = 0; i < 8; ++i) {
+					value |= static_cast<std::uint64_t>(static_cast<unsigned char>(m_Data[i])) << (i * 8);
+				}
+				m_Data.remove_prefix(8);
+				return value;
+			}
+			std::string ReadString() {
+				const std::uint64_t size = ReadInteger();
+				if (m_HasError || m_Data.size() < size) return m_HasError = true, std::string();
+
+				std::string result(m_Data.substr(0, static_cast<std::size_t>(size)));
+				m_Data.remove_prefix(static_cast<std::size_t>(size));
+				return result;
+			}
+			std::size_t ReadCount() noexcept {
+				const std::uint64_t count = ReadInteger();
+				if (count > m_Data.size()) return m_HasError = true, 0; // Every element takes at least one byte
+				return static_cast<std::size_t>(count);
+			}
+		};
+	}
+
+	ModuleCache::ModuleCache(std::filesystem::path directory)
+		: m_Directory(std::move(directory)) {}
+
+	// Only checks the write time and size of the source, so the source is not read.
+	std::optional<ModuleInterface> ModuleCache::Load(std::string_view path) const {
+		auto entry = LoadEntry(path);
+		if (!entry) return std::nullopt;
+
+		const auto state = GetFileState(path);
+		if (!state || state->first != entry->WriteTime || state->second != entry->Size) return std::nullopt;
+		else return std::move(entry->Interface);
+	}
+	std::optional<ModuleInterface> ModuleCache::Load(std::string_view path, std::uint64_t contentHash) const {
+		auto entry = LoadEntry(path);
+		if (!entry || entry->Interface.ContentHash != contentHash) return std::nullopt;
+		else return std::move(entry->Interface);
+	}
+	bool ModuleCache::Store(std::string_view path, std::uint64_t contentHash, const ModuleInterface& interface) const {
+		const auto state = GetFileState(path);
+		if (!state) return false;
+
+		// Modules imported only indirectly have prototypes only, which must not replace a complete entry
+		if (!interface.IsComplete) {
+			if (const auto entry = Load(path, contentHash); entry && entry->IsComplete) return true;
+		}
+
+		Writer writer;
+		writer.Data.append(Magic, sizeof(Magic));
+		writer.Write(Version);
+		writer.Write(path);
+		writer.Write(contentHash);
+		writer.Write(state->first);
+		writer.Write(state->second);
+		writer.Write(interface.IsComplete);
+		writer.Write(interface.Imports.size());
+		for (const auto& import : interface.Imports) {
+			writer.Write(import.Path);
+			writer.Write(import.NameSpace);
+		}
+
+		writer.Write(interface.Structures.size());
+		for (const auto& structure : interface.Structures) {
+			writer.Write(structure.Name);
+			writer.Write(structure.Fields.size());
+			for (const auto& field : structure.Fields) {
+				writer.Write(field.Name);
+				writer.Write(field.TypeName);
+				writer.Write(field.ElementCount.has_value());
+				if (field.ElementCount) {
+					writer.Write(*field.ElementCount);
+				}
+			}
+		}
+
+		writer.Write(interface.Functions.size());
+		for (const auto& function : interface.Functions) {
+			writer.Write(function.Name);
+			writer.Write(function.Arity);
+			writer.Write(function.HasResult);
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(m_Directory, error);
+		if (error) return false;
+
+		// Write to a unique temporary file first, so that concurrent readers never see a partial entry.
+		const std::filesystem::path entryPath = GetEntryPath(path);
+		std::ostringstream temporaryName;
+		temporaryName << entryPath.filename().string() << '.' << std::hex << std::random_device()() << ".tmp";
+		const std::filesystem::path temporaryPath = m_Directory / temporaryName.str();
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!stream || !stream.write(writer.Data.data(), static_cast<std::streamsize>(writer.Data.size()))) return false;
+		}
+
+		std::filesystem::rename(temporaryPath, entryPath, error);
+		if (error) {
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		} else return true;
+	}
+
+	std::uint64_t ModuleCache::Hash(std::string_view data) noexcept {
+		std::uint64_t hash = 0xCBF29CE484222325;
+		for (const char c : data) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001B3;
+		}
+		return hash;
+	}
+
+	std::optional<ModuleCache::Entry> ModuleCache::LoadEntry(std::string_view path) const {
+		std::ifstream stream(GetEntryPath(path), std::ios::binary);
+		if (!stream) return std::nullopt;
+
+		const std::string data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		if (data.size() < sizeof(Magic) || data.compare(0, sizeof(Magic), Magic, sizeof(Magic)) != 0) return std::nullopt;
+
+		Reader reader(std::string_view(data).substr(sizeof(Magic)));
+		if (reader.ReadInteger() != Version || reader.ReadString() != path) return std::nullopt;
+
+		Entry result;
+		result.Interface.ContentHash = reader.ReadInteger();
+		result.WriteTime = reader.ReadInteger();
+		result.Size = reader.ReadInteger();
+		result.Interface.IsComplete = reader.ReadInteger() != 0;
+
+		result.Interface.Imports.resize(reader.ReadCount());
+		for (auto& import : result.Interface.Imports) {
+			import.Path = reader.ReadString();
+			import.NameSpace = reader.ReadString();
+		}
+
+		result.Interface.Structures.resize(reader.ReadCount());
+		for (auto& structure : result.Interface.Structures) {
+			structure.Name = reader.ReadString();
+			structure.Fields.resize(reader.ReadCount());
+			for (auto& field : structure.Fields) {
+				field.Name = reader.ReadString();
+				field.TypeName = reader.ReadString();
+				if (reader.ReadInteger() != 0) {
+					field.ElementCount = reader.ReadInteger();
+				}
+			}
+		}
+
+		result.Interface.Functions.resize(reader.ReadCount());
+		for (auto& function : result.Interface.Functions) {
+			function.Name = reader.ReadString();
+			function.Arity = static_cast<std::uint16_t>(reader.ReadInteger());
+			function.HasResult = reader.ReadInteger() != 0;
+		}
+
+		if (reader.HasError()) return std::nullopt;
+		else return result;
+	}
+	std::filesystem::path ModuleCache::GetEntryPath(std::string_view path) const {
+		char name[21];
+		std::snprintf(name, sizeof(name), "%016llx.sbi", static_cast<unsigned long long>(Hash(path)));
+		return m_Directory / name;
+	}
+
+	std::optional<std::pair<std::uint64_t, std::uint64_t>> ModuleCache::GetFileState(std::string_view path) {
+		std::error_code error;
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+		if (error) return std::nullopt;
+
+		const auto size = std::filesystem::file_size(path, error);
+		if (error) return std::nullopt;
+		else return std::make_pair(static_cast<std::uint64_t>(writeTime.time_since_epoch().count()), static_cast<std::uint64_t>(size));
+	}
+}
\ No newline at end of file
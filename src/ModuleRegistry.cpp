@@ -0,0 +1,102 @@
+#include <sam/ModuleRegistry.hpp>
+
+#include <sam/Source.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+
+namespace sam {
+	std::optional<ModuleInterface> ModuleRegistry::Find(const std::string& path) const {
+		std::lock_guard lock(m_Mutex);
+		if (const auto iter = m_Modules.find(path); iter != m_Modules.end()) return iter->second.Interface;
+		else return std::nullopt;
+	}
+	void ModuleRegistry::Register(const std::string& path, ModuleInterface interface) {
+		std::error_code error;
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+
+		std::lock_guard lock(m_Mutex);
+		if (const auto iter = m_Modules.find(path); iter == m_Modules.end()) {
+			m_Modules.emplace(path, Entry{ std::move(interface), writeTime });
+		} else if (!iter->second.Interface.IsComplete) {
+			iter->second = Entry{ std::move(interface), writeTime };
+		}
+	}
+	// Waits while another thread loads the module, unless that load waits for one of the importing modules in turn.
+	// true if the caller has to load it, and then has to call EndLoad.
+	bool ModuleRegistry::BeginLoad(const std::string& path, const std::vector<std::string>& importChain) {
+		std::unique_lock lock(m_Mutex);
+		while (m_Modules.find(path) == m_Modules.end()) {
+			if (m_LoadingModules.find(path) == m_LoadingModules.end()) {
+				m_LoadingModules.emplace(path, importChain);
+				return true;
+			} else if (IsAwaitedBy(path, importChain)) return false; // The caller parses it by itself
+
+			if (importChain.empty()) {
+				m_LoadedCondition.wait(lock);
+			} else {
+				m_Waits.emplace_back(importChain.back(), path);
+				m_LoadedCondition.wait(lock);
+				m_Waits.erase(std::find(m_Waits.begin(), m_Waits.end(), std::make_pair(importChain.back(), path)));
+			}
+		}
+		return false;
+	}
+	void ModuleRegistry::EndLoad(const std::string& path) {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_LoadingModules.erase(path);
+		}
+		m_LoadedCondition.notify_all();
+	}
+	bool ModuleRegistry::IsAwaitedBy(const std::string& path, const std::vector<std::string>& importChain) const {
+		// A load waits for the modules it imports, and for the ones they are waiting for
+		std::vector<std::string_view> pending{ path };
+		std::unordered_set<std::string_view> visited;
+		while (!pending.empty()) {
+			const std::string_view module = pending.back();
+			pending.pop_back();
+			if (std::find(importChain.begin(), importChain.end(), module) != importChain.end()) return true;
+			else if (!visited.insert(module).second) continue;
+
+			for (const auto& [loadingPath, loaderChain] : m_LoadingModules) {
+				if (!loaderChain.empty() && loaderChain.back() == module) {
+					pending.push_back(loadingPath);
+				}
+			}
+			for (const auto& [importingPath, awaitedPath] : m_Waits) {
+				if (importingPath == module) {
+					pending.push_back(awaitedPath);
+				}
+			}
+		}
+		return false;
+	}
+	std::size_t ModuleRegistry::Revalidate() {
+		std::lock_guard lock(m_Mutex);
+
+		std::size_t invalidatedCount = 0;
+		for (auto iter = m_Modules.begin(); iter != m_Modules.end();) {
+			std::error_code error;
+			const auto writeTime = std::filesystem::last_write_time(iter->first, error);
+			if (!error && writeTime == iter->second.WriteTime) {
+				++iter;
+				continue;
+			}
+
+			// Touched files are kept as long as their contents are the same.
+			Source source;
+			if (!error && source.Open(iter->first) && ModuleCache::Hash(source.GetData()) == iter->second.Interface.ContentHash) {
+				iter->second.WriteTime = writeTime;
+				++iter;
+			} else {
+				iter = m_Modules.erase(iter);
+				++invalidatedCount;
+			}
+		}
+		return invalidatedCount;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,1534 @@
+#include <sam/Optimizer.hpp>
+
+#include <sam/ExternModule.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sam {
+	std::optional<Symbol> GetLocalVariableOperand(const Instruction& instruction) noexcept {
+		switch (instruction.Mnemonic) {
+		case Mnemonic::Load:
+		case Mnemonic::Store:
+		case Mnemonic::Lea:
+			return std::get<Symbol>(instruction.Operand);
+
+		case Mnemonic::String32:
+			return std::get<StringOperand>(instruction.Operand).LocalVariable;
+
+		default:
+			return std::nullopt;
+		}
+	}
+
+	namespace {
+		bool IsNumberOperand(const Operand& operand) noexcept {
+			return std::holds_alternative<std::uint32_t>(operand) || std::holds_alternative<std::uint64_t>(operand) ||
+				std::holds_alternative<float>(operand) || std::holds_alternative<double>(operand);
+		}
+
+		using Constant = std::variant<std::uint32_t, std::uint64_t, float, double>; // int, long, single, double
+
+		std::optional<Constant> GetConstant(const Instruction& instruction) noexcept {
+			if (instruction.Mnemonic != Mnemonic::Push) return std::nullopt;
+			else if (std::holds_alternative<std::uint32_t>(instruction.Operand)) return std::get<std::uint32_t>(instruction.Operand);
+			else if (std::holds_alternative<std::uint64_t>(instruction.Operand)) return std::get<std::uint64_t>(instruction.Operand);
+			else if (std::holds_alternative<float>(instruction.Operand)) return std::get<float>(instruction.Operand);
+			else if (std::holds_alternative<double>(instruction.Operand)) return std::get<double>(instruction.Operand);
+			else return std::nullopt;
+		}
+		Operand ToOperand(const Constant& constant) noexcept {
+			return std::visit([](auto value) { return Operand(value); }, constant);
+		}
+
+		template<typename T>
+		std::optional<Constant> FoldBinary(Mnemonic mnemonic, T lhs, T rhs) noexcept {
+			if constexpr (std::is_integral_v<T>) {
+				using Signed = std::make_signed_t<T>;
+				constexpr T width = std::numeric_limits<T>::digits;
+				const bool isSignedOverflow = static_cast<Signed>(lhs) == std::numeric_limits<Signed>::min() && static_cast<Signed>(rhs) == -1;
+
+				switch (mnemonic) {
+				case Mnemonic::Add: return static_cast<T>(lhs + rhs);
+				case Mnemonic::Sub: return static_cast<T>(lhs - rhs);
+				case Mnemonic::Mul:
+				case Mnemonic::IMul: return static_cast<T>(lhs * rhs); // Same bits in two's complement
+				case Mnemonic::Div: if (rhs == 0) return std::nullopt; else return static_cast<T>(lhs / rhs);
+				case Mnemonic::IDiv: if (rhs == 0 || isSignedOverflow) return std::nullopt; else return static_cast<T>(static_cast<Signed>(lhs) / static_cast<Signed>(rhs));
+				case Mnemonic::Mod: if (rhs == 0) return std::nullopt; else return static_cast<T>(lhs % rhs);
+				case Mnemonic::IMod: if (rhs == 0 || isSignedOverflow) return std::nullopt; else return static_cast<T>(static_cast<Signed>(lhs) % static_cast<Signed>(rhs));
+				case Mnemonic::And: return static_cast<T>(lhs & rhs);
+				case Mnemonic::Or: return static_cast<T>(lhs | rhs);
+				case Mnemonic::Xor: return static_cast<T>(lhs ^ rhs);
+				case Mnemonic::Shl:
+				case Mnemonic::Sal: if (rhs >= width) return std::nullopt; else return static_cast<T>(lhs << rhs);
+				case Mnemonic::Shr: if (rhs >= width) return std::nullopt; else return static_cast<T>(lhs >> rhs);
+				case Mnemonic::Sar: if (rhs >= width) return std::nullopt; else return static_cast<T>(static_cast<Signed>(lhs) >> rhs);
+				default: return std::nullopt;
+				}
+			} else {
+				switch (mnemonic) {
+				case Mnemonic::Add: return lhs + rhs;
+				case Mnemonic::Sub: return lhs - rhs;
+				case Mnemonic::Mul: return lhs * rhs;
+				case Mnemonic::Div: if (rhs == 0) return std::nullopt; else return lhs / rhs;
+				default: return std::nullopt;
+				}
+			}
+		}
+		std::optional<Constant> FoldBinary(Mnemonic mnemonic, const Constant& lhs, const Constant& rhs) noexcept {
+			if (lhs.index() != rhs.index()) return std::nullopt; // The VM rejects mixed operands
+
+			return std::visit([mnemonic, &rhs](auto value) {
+				return FoldBinary(mnemonic, value, std::get<decltype(value)>(rhs));
+			}, lhs);
+		}
+
+		// Conversions are folded only where signed and unsigned interpretations agree.
+		template<typename T, typename U>
+		std::optional<Constant> Convert(U value) noexcept {
+			if constexpr (std::is_same_v<T, U>) return value;
+			else if constexpr (std::is_integral_v<U>) {
+				if constexpr (std::is_integral_v<T>) {
+					if (sizeof(T) < sizeof(U) || static_cast<std::make_signed_t<U>>(value) >= 0) return static_cast<T>(value);
+				} else if (static_cast<std::make_signed_t<U>>(value) >= 0) return static_cast<T>(value);
+				return std::nullopt;
+			} else if constexpr (std::is_integral_v<T>) {
+				constexpr U limit = static_cast<U>(static_cast<std::make_unsigned_t<T>>(std::numeric_limits<std::make_signed_t<T>>::max()) + 1);
+				if (value >= 0 && value < limit && std::trunc(value) == value) return static_cast<T>(value);
+				else return std::nullopt;
+			} else return static_cast<T>(value);
+		}
+		std::optional<Constant> FoldUnary(Mnemonic mnemonic, const Constant& operand) noexcept {
+			return std::visit([mnemonic](auto value) -> std::optional<Constant> {
+				using T = decltype(value);
+				switch (mnemonic) {
+				case Mnemonic::Neg:
+					if constexpr (std::is_integral_v<T>) return static_cast<T>(T(0) - value);
+					else return -value;
+				case Mnemonic::Not:
+					if constexpr (std::is_integral_v<T>) return static_cast<T>(~value);
+					else return std::nullopt;
+				case Mnemonic::ToI: return Convert<std::uint32_t>(value);
+				case Mnemonic::ToL: return Convert<std::uint64_t>(value);
+				case Mnemonic::ToSi: return Convert<float>(value);
+				case Mnemonic::ToD: return Convert<double>(value);
+				default: return std::nullopt;
+				}
+			}, operand);
+		}
+
+		Assembly* FindAssembly(Assembly& assembly, Symbol nameSpace) {
+			if (nameSpace == Symbol::Empty) return &assembly;
+
+			auto dependency = assembly.FindDependencyByNameSpace(nameSpace);
+			if (dependency == assembly.Dependencies.end()) {
+				dependency = assembly.FindDependency(nameSpace); // Standard modules referred to by path after static linking
+				if (dependency == assembly.Dependencies.end()) return nullptr;
+			}
+			return &dependency->Assembly;
+		}
+		bool HasStructure(Assembly& assembly, const Name& name) {
+			Assembly* const structureAssembly = FindAssembly(assembly, name.NameSpace);
+			if (!structureAssembly) return false;
+
+			const auto structure = structureAssembly->FindStructure(name.Identifier);
+			return structure != structureAssembly->Structures.end() && (name.Member == Symbol::Empty || structure->HasField(name.Member));
+		}
+
+		struct StackEffect final {
+			std::size_t Pops = 0;
+			std::size_t Pushes = 0;
+		};
+
+		std::optional<StackEffect> GetStackEffect(const Instruction& instruction, Assembly& assembly) {
+			switch (instruction.Mnemonic) {
+			case Mnemonic::Nop:
+			case Mnemonic::Jmp:
+			case Mnemonic::Je:
+			case Mnemonic::Jne:
+			case Mnemonic::Ja:
+			case Mnemonic::Jae:
+			case Mnemonic::Jb:
+			case Mnemonic::Jbe:
+			case Mnemonic::String32:
+			case Mnemonic::Label:
+				return StackEffect{ 0, 0 };
+
+			case Mnemonic::Push:
+			case Mnemonic::Load:
+			case Mnemonic::Lea:
+			case Mnemonic::Null:
+			case Mnemonic::New:
+			case Mnemonic::GCNull:
+			case Mnemonic::GCNew:
+				return StackEffect{ 0, 1 };
+
+			case Mnemonic::Pop:
+			case Mnemonic::Store:
+			case Mnemonic::Inc:
+			case Mnemonic::Dec:
+			case Mnemonic::Delete:
+				return StackEffect{ 1, 0 };
+
+			case Mnemonic::FLea:
+			case Mnemonic::TLoad:
+			case Mnemonic::Neg:
+			case Mnemonic::Not:
+			case Mnemonic::ToI:
+			case Mnemonic::ToL:
+			case Mnemonic::ToSi:
+			case Mnemonic::ToD:
+			case Mnemonic::ToP:
+			case Mnemonic::APush:
+			case Mnemonic::ANew:
+			case Mnemonic::AGCNew:
+			case Mnemonic::Count:
+				return StackEffect{ 1, 1 };
+
+			case Mnemonic::TStore: return StackEffect{ 2, 0 };
+			case Mnemonic::Copy: return StackEffect{ 1, 2 };
+			case Mnemonic::Swap: return StackEffect{ 2, 2 };
+
+			case Mnemonic::Add:
+			case Mnemonic::Sub:
+			case Mnemonic::Mul:
+			case Mnemonic::IMul:
+			case Mnemonic::Div:
+			case Mnemonic::IDiv:
+			case Mnemonic::Mod:
+			case Mnemonic::IMod:
+			case Mnemonic::And:
+			case Mnemonic::Or:
+			case Mnemonic::Xor:
+			case Mnemonic::Shl:
+			case Mnemonic::Sal:
+			case Mnemonic::Shr:
+			case Mnemonic::Sar:
+			case Mnemonic::Cmp:
+			case Mnemonic::ICmp:
+			case Mnemonic::ALea:
+				return StackEffect{ 2, 1 };
+
+			case Mnemonic::Call: {
+				const Name& name = std::get<Name>(instruction.Operand);
+				Assembly* const calleeAssembly = FindAssembly(assembly, name.NameSpace);
+				if (!calleeAssembly) return std::nullopt;
+
+				const auto callee = calleeAssembly->FindFunction(name.Identifier);
+				if (callee == calleeAssembly->Functions.end()) return std::nullopt;
+				else return StackEffect{ callee->Arity, callee->HasResult ? 1u : 0u };
+			}
+
+			default:
+				return std::nullopt;
+			}
+		}
+
+		// Stack depth before each instruction and, as the last element, at the end of the body, relative to the start of the function.
+		// std::nullopt if any instruction has an unknown stack effect, underflows, or is reached with different depths.
+		std::optional<std::vector<std::optional<std::size_t>>> GetStackDepths(const Function& function, Assembly& assembly) {
+			const std::vector<Instruction>& instructions = function.Instructions;
+
+			std::unordered_map<Symbol, std::size_t> labels; // (Label, Instruction)
+			for (std::size_t i = 0; i < instructions.size(); ++i) {
+				if (instructions[i].Mnemonic == Mnemonic::Label) {
+					labels.emplace(std::get<Symbol>(instructions[i].Operand), i);
+				}
+			}
+
+			std::vector<std::optional<std::size_t>> depths(instructions.size() + 1);
+			std::vector<std::size_t> worklist;
+			const auto visit = [&](std::size_t i, std::size_t depth) {
+				if (depths[i]) return *depths[i] == depth;
+
+				depths[i] = depth;
+				if (i < instructions.size()) {
+					worklist.push_back(i);
+				}
+				return true;
+			};
+
+			visit(0, 0);
+			while (!worklist.empty()) {
+				const std::size_t i = worklist.back();
+				worklist.pop_back();
+
+				const Instruction& instruction = instructions[i];
+				if (instruction.Mnemonic == Mnemonic::Ret) continue;
+
+				const auto effect = GetStackEffect(instruction, assembly);
+				if (!effect || *depths[i] < effect->Pops) return std::nullopt;
+
+				const std::size_t depth = *depths[i] - effect->Pops + effect->Pushes;
+				switch (instruction.Mnemonic) {
+				case Mnemonic::Jmp:
+				case Mnemonic::Je:
+				case Mnemonic::Jne:
+				case Mnemonic::Ja:
+				case Mnemonic::Jae:
+				case Mnemonic::Jb:
+				case Mnemonic::Jbe: {
+					// A taken conditional jump pops the result of the comparison
+					const auto label = labels.find(std::get<Symbol>(instruction.Operand));
+					const std::size_t popCount = instruction.Mnemonic == Mnemonic::Jmp ? 0 : 1;
+					if (label == labels.end() || depth < popCount || !visit(label->second, depth - popCount)) return std::nullopt;
+					else if (instruction.Mnemonic == Mnemonic::Jmp) continue;
+					break;
+				}
+
+				default: break;
+				}
+
+				if (!visit(i + 1, depth)) return std::nullopt;
+			}
+			return depths;
+		}
+
+		// A body can replace a call only if every path ends with 'ret' leaving just the result on the stack,
+		// since anything else left there would belong to the caller after inlining.
+		bool IsInlinable(const Function& function, Assembly& assembly) {
+			const std::vector<Instruction>& instructions = function.Instructions;
+			if (function.Name == Symbol::Entrypoint || instructions.empty()) return false;
+
+			// Bodies that would fail to lower are not copied, so that their errors are reported only once
+			std::unordered_set<Symbol> localVariables;
+			for (std::size_t i = 0; i < function.Arity; ++i) {
+				localVariables.insert(function.LocalVariables[i].Name);
+			}
+
+			for (const auto& instruction : instructions) {
+				if (instruction.Mnemonic == Mnemonic::Store || instruction.Mnemonic == Mnemonic::String32) {
+					localVariables.insert(*GetLocalVariableOperand(instruction));
+				} else if (const auto localVariable = GetLocalVariableOperand(instruction)) {
+					if (!localVariables.count(*localVariable)) return false;
+				} else if (instruction.Mnemonic == Mnemonic::Call) {
+					const Name& name = std::get<Name>(instruction.Operand);
+					if (name.NameSpace == Symbol::Empty && name.Identifier == function.Name) return false; // Recursive
+				} else if (std::holds_alternative<Name>(instruction.Operand)) {
+					if (!HasStructure(assembly, std::get<Name>(instruction.Operand))) return false;
+				}
+			}
+
+			const auto depths = GetStackDepths(function, assembly);
+			if (!depths || depths->back()) return false; // Falls off the end
+
+			for (std::size_t i = 0; i < instructions.size(); ++i) {
+				const auto depth = (*depths)[i];
+				if (instructions[i].Mnemonic == Mnemonic::Ret && depth && *depth != (function.HasResult ? 1 : 0)) return false;
+			}
+			return true;
+		}
+
+		struct InlineCandidate final {
+			Symbol Name;
+			std::vector<Symbol> Parameters;
+			std::vector<Instruction> Instructions;
+		};
+
+		void InlineCall(Function& caller, const InlineCandidate& callee, Symbol prefix, std::size_t token, SymbolTable& symbols,
+			std::vector<Instruction>& output) {
+			// Locals and labels of the callee are renamed to '<prefix>.<name>', which cannot be written in the source
+			std::unordered_map<Symbol, Symbol> renamed;
+			const auto rename = [&](Symbol name) {
+				const auto [iter, isInserted] = renamed.try_emplace(name);
+				if (isInserted) {
+					iter->second = symbols.Concat(prefix, name);
+				}
+				return iter->second;
+			};
+
+			// Arguments are on the stack with the first one on top
+			for (const Symbol param : callee.Parameters) {
+				output.push_back({ Mnemonic::Store, rename(param), token });
+			}
+
+			bool hasEnd = false;
+			for (std::size_t i = 0; i < callee.Instructions.size(); ++i) {
+				Instruction instruction = callee.Instructions[i];
+				instruction.Token = token;
+
+				switch (instruction.Mnemonic) {
+				case Mnemonic::Ret:
+					if (i + 1 == callee.Instructions.size()) continue;
+
+					instruction = { Mnemonic::Jmp, prefix, token };
+					hasEnd = true;
+					break;
+
+				case Mnemonic::Label:
+					instruction.Operand = rename(std::get<Symbol>(instruction.Operand));
+					caller.AddLabel(Label{ std::get<Symbol>(instruction.Operand) });
+					break;
+
+				case Mnemonic::Jmp:
+				case Mnemonic::Je:
+				case Mnemonic::Jne:
+				case Mnemonic::Ja:
+				case Mnemonic::Jae:
+				case Mnemonic::Jb:
+				case Mnemonic::Jbe:
+				case Mnemonic::Load:
+				case Mnemonic::Store:
+				case Mnemonic::Lea:
+					instruction.Operand = rename(std::get<Symbol>(instruction.Operand));
+					break;
+
+				case Mnemonic::String32: {
+					Symbol& localVariable = std::get<StringOperand>(instruction.Operand).LocalVariable;
+					localVariable = rename(localVariable);
+					break;
+				}
+
+				default: break;
+				}
+				output.push_back(std::move(instruction));
+			}
+
+			if (hasEnd) {
+				output.push_back({ Mnemonic::Label, prefix, token });
+				caller.AddLabel(Label{ prefix });
+			}
+		}
+
+		bool IsJump(Mnemonic mnemonic) noexcept {
+			return mnemonic >= Mnemonic::Jmp && mnemonic <= Mnemonic::Jbe;
+		}
+
+		struct BasicBlock final {
+			std::size_t Begin = 0;
+			std::size_t End = 0; // Exclusive
+			std::vector<std::size_t> Successors;
+		};
+
+		// Blocks start at labels and after jumps and 'ret'. std::nullopt if a jump refers to a nonexistent label.
+		std::optional<std::vector<BasicBlock>> BuildControlFlowGraph(const Function& function) {
+			const std::vector<Instruction>& instructions = function.Instructions;
+
+			std::vector<BasicBlock> blocks;
+			std::unordered_map<Symbol, std::size_t> labelBlocks; // (Label, Block)
+			for (std::size_t i = 0; i < instructions.size(); ++i) {
+				const Mnemonic mnemonic = instructions[i].Mnemonic;
+				const Mnemonic previous = i > 0 ? instructions[i - 1].Mnemonic : Mnemonic::None;
+				if (i == 0 || mnemonic == Mnemonic::Label || previous == Mnemonic::Ret || IsJump(previous)) {
+					blocks.push_back({ i, i });
+				}
+				if (mnemonic == Mnemonic::Label) {
+					labelBlocks.emplace(std::get<Symbol>(instructions[i].Operand), blocks.size() - 1);
+				}
+				blocks.back().End = i + 1;
+			}
+
+			for (std::size_t i = 0; i < blocks.size(); ++i) {
+				const Instruction& last = instructions[blocks[i].End - 1];
+				const bool hasNext = i + 1 < blocks.size();
+				if (last.Mnemonic == Mnemonic::Ret) continue;
+				else if (IsJump(last.Mnemonic)) {
+					const auto target = labelBlocks.find(std::get<Symbol>(last.Operand));
+					if (target == labelBlocks.end()) return std::nullopt;
+
+					blocks[i].Successors.push_back(target->second);
+					if (last.Mnemonic != Mnemonic::Jmp && hasNext) {
+						blocks[i].Successors.push_back(i + 1);
+					}
+				} else if (hasNext) {
+					blocks[i].Successors.push_back(i + 1);
+				}
+			}
+			return blocks;
+		}
+
+		// Whether lowering the instruction would succeed, apart from its local variable
+		bool CanLower(const Instruction& instruction, Assembly& assembly, const std::unordered_map<Symbol, std::size_t>& labels) {
+			if (IsJump(instruction.Mnemonic)) return labels.count(std::get<Symbol>(instruction.Operand)) != 0;
+			else if (instruction.Mnemonic == Mnemonic::Call) {
+				const Name& name = std::get<Name>(instruction.Operand);
+				Assembly* const calleeAssembly = FindAssembly(assembly, name.NameSpace);
+				return calleeAssembly && name.Identifier != Symbol::Entrypoint && calleeAssembly->HasFunction(name.Identifier);
+			} else if (std::holds_alternative<Name>(instruction.Operand)) return HasStructure(assembly, std::get<Name>(instruction.Operand));
+			else if (std::holds_alternative<Type>(instruction.Operand)) return HasStructure(assembly, std::get<Type>(instruction.Operand).ElementTypeName);
+			else return instruction.Mnemonic != Mnemonic::String32; // Requires a module to be imported
+		}
+
+		enum class StackType : std::uint8_t {
+			Unknown,
+			Int,
+			Long,
+			Single,
+			Double,
+			Pointer,
+			GCPointer,
+			Structure,
+			Array,
+		};
+
+		struct StackState final {
+			std::vector<StackType> Values;
+			std::unordered_map<Symbol, StackType> LocalVariables; // Absent ones are unknown
+		};
+
+		std::string GetTypeName(StackType type) {
+			static constexpr std::string_view names[] = { "unknown", "int", "long", "single", "double", "pointer", "gcpointer", "structure", "array" };
+			return std::string(names[static_cast<std::size_t>(type)]);
+		}
+		std::string GetMnemonicName(Mnemonic mnemonic) {
+			for (const auto& info : Mnemonics) {
+				if (info.Mnemonic == mnemonic) return std::string(info.Name);
+			}
+			return "label";
+		}
+		// Unknown types pass, so that only what is certain to fail is reported
+		bool IsPointer(StackType type) noexcept {
+			return type == StackType::Unknown || type == StackType::Pointer || type == StackType::GCPointer;
+		}
+		bool IsArithmetic(StackType type) noexcept {
+			return type <= StackType::Double;
+		}
+
+		// Types that differ between paths become unknown. false if the depths differ.
+		bool MergeStackState(StackState& state, const StackState& other, bool& isChanged) {
+			if (state.Values.size() != other.Values.size()) return false;
+
+			for (std::size_t i = 0; i < state.Values.size(); ++i) {
+				if (state.Values[i] != other.Values[i] && state.Values[i] != StackType::Unknown) {
+					state.Values[i] = StackType::Unknown;
+					isChanged = true;
+				}
+			}
+			for (auto& [name, type] : state.LocalVariables) {
+				const auto otherType = other.LocalVariables.find(name);
+				if (type != StackType::Unknown && (otherType == other.LocalVariables.end() || otherType->second != type)) {
+					type = StackType::Unknown;
+					isChanged = true;
+				}
+			}
+			return true;
+		}
+
+		// Applies the instruction to the state, except for what a taken jump pops and what 'ret' requires.
+		// Returns a message if the instruction cannot execute in the state, in which case the state is left unusable.
+		std::optional<std::string> ExecuteInstruction(const Instruction& instruction, Assembly& assembly, StackState& state) {
+			const Mnemonic mnemonic = instruction.Mnemonic;
+			std::vector<StackType>& values = state.Values;
+
+			std::size_t popCount = 0;
+			if (IsJump(mnemonic)) {
+				popCount = mnemonic == Mnemonic::Jmp ? 0 : 1;
+			} else if (const auto effect = GetStackEffect(instruction, assembly)) {
+				popCount = effect->Pops;
+			}
+			if (values.size() < popCount) {
+				if (mnemonic == Mnemonic::Pop) return std::nullopt; // Deletes the last local variable instead
+
+				return "Stack underflow in '" + GetMnemonicName(mnemonic) + "', required " + std::to_string(popCount) + " value(s) but found " +
+					std::to_string(values.size());
+			}
+
+			const auto pop = [&values]() {
+				const StackType type = values.back();
+				values.pop_back();
+				return type;
+			};
+			const auto requirePointer = [mnemonic](StackType type) -> std::optional<std::string> {
+				if (IsPointer(type)) return std::nullopt;
+				else return "Excepted pointer for '" + GetMnemonicName(mnemonic) + "', found '" + GetTypeName(type) + "'";
+			};
+			const auto requireSameTypes = [mnemonic](StackType lhs, StackType rhs) -> std::optional<std::string> {
+				if (lhs == rhs || lhs == StackType::Unknown || rhs == StackType::Unknown) return std::nullopt;
+				else return "Mismatched types '" + GetTypeName(lhs) + "' and '" + GetTypeName(rhs) + "' for '" + GetMnemonicName(mnemonic) + "'";
+			};
+			const auto requireArithmetic = [mnemonic](StackType type) -> std::optional<std::string> {
+				if (IsArithmetic(type)) return std::nullopt;
+				else return "Invalid type '" + GetTypeName(type) + "' for '" + GetMnemonicName(mnemonic) + "'";
+			};
+
+			switch (mnemonic) {
+			case Mnemonic::Push:
+				if (std::holds_alternative<std::uint32_t>(instruction.Operand)) values.push_back(StackType::Int);
+				else if (std::holds_alternative<std::uint64_t>(instruction.Operand)) values.push_back(StackType::Long);
+				else if (std::holds_alternative<float>(instruction.Operand)) values.push_back(StackType::Single);
+				else if (std::holds_alternative<double>(instruction.Operand)) values.push_back(StackType::Double);
+				else values.push_back(StackType::Structure);
+				return std::nullopt;
+
+			case Mnemonic::Pop: pop(); return std::nullopt;
+			case Mnemonic::Load: {
+				const auto localVariable = state.LocalVariables.find(std::get<Symbol>(instruction.Operand));
+				values.push_back(localVariable != state.LocalVariables.end() ? localVariable->second : StackType::Unknown);
+				return std::nullopt;
+			}
+			case Mnemonic::Store: state.LocalVariables[std::get<Symbol>(instruction.Operand)] = pop(); return std::nullopt;
+			case Mnemonic::String32: state.LocalVariables[std::get<StringOperand>(instruction.Operand).LocalVariable] = StackType::Structure; return std::nullopt;
+			case Mnemonic::Lea: values.push_back(StackType::Pointer); return std::nullopt;
+
+			case Mnemonic::FLea:
+			case Mnemonic::ALea: {
+				const StackType index = mnemonic == Mnemonic::ALea ? pop() : StackType::Int;
+				const StackType pointer = pop();
+				values.push_back(pointer == StackType::Pointer ? StackType::Pointer : StackType::Unknown);
+				if (auto error = requirePointer(pointer)) return error;
+				else return requireArithmetic(index);
+			}
+			case Mnemonic::TLoad: {
+				const StackType pointer = pop();
+				values.push_back(StackType::Unknown);
+				return requirePointer(pointer);
+			}
+			case Mnemonic::TStore:
+				pop();
+				return requirePointer(pop());
+
+			case Mnemonic::Copy: values.push_back(values.back()); return std::nullopt;
+			case Mnemonic::Swap: {
+				const StackType rhs = pop(), lhs = pop();
+				values.push_back(rhs);
+				values.push_back(lhs);
+				return requireSameTypes(lhs, rhs);
+			}
+
+			case Mnemonic::Add:
+			case Mnemonic::Sub:
+			case Mnemonic::Mul:
+			case Mnemonic::IMul:
+			case Mnemonic::Div:
+			case Mnemonic::IDiv:
+			case Mnemonic::Mod:
+			case Mnemonic::IMod:
+			case Mnemonic::And:
+			case Mnemonic::Or:
+			case Mnemonic::Xor:
+			case Mnemonic::Shl:
+			case Mnemonic::Sal:
+			case Mnemonic::Shr:
+			case Mnemonic::Sar:
+			case Mnemonic::Cmp:
+			case Mnemonic::ICmp: {
+				const StackType rhs = pop(), lhs = pop();
+				if (mnemonic == Mnemonic::Cmp || mnemonic == Mnemonic::ICmp) {
+					values.push_back(StackType::Int);
+				} else {
+					values.push_back(lhs != StackType::Unknown ? lhs : rhs);
+				}
+
+				if (auto error = requireArithmetic(lhs)) return error;
+				else if (auto error = requireArithmetic(rhs)) return error;
+				else return requireSameTypes(lhs, rhs);
+			}
+			case Mnemonic::Neg:
+			case Mnemonic::Not: return requireArithmetic(values.back());
+			case Mnemonic::Inc:
+			case Mnemonic::Dec: return requirePointer(pop());
+
+			case Mnemonic::ToI:
+			case Mnemonic::ToL:
+			case Mnemonic::ToSi:
+			case Mnemonic::ToD:
+			case Mnemonic::ToP: {
+				const StackType type = pop();
+				static constexpr StackType results[] = { StackType::Int, StackType::Long, StackType::Single, StackType::Double, StackType::Pointer };
+				values.push_back(results[static_cast<std::size_t>(mnemonic) - static_cast<std::size_t>(Mnemonic::ToI)]);
+				if (type == StackType::Structure || type == StackType::Array) return requireArithmetic(type);
+				else return std::nullopt;
+			}
+
+			case Mnemonic::Null:
+			case Mnemonic::New: values.push_back(StackType::Pointer); return std::nullopt;
+			case Mnemonic::GCNull:
+			case Mnemonic::GCNew: values.push_back(StackType::GCPointer); return std::nullopt;
+			case Mnemonic::Delete: {
+				const StackType type = pop();
+				if (type == StackType::GCPointer) return "Invalid type 'gcpointer' for 'delete'";
+				else return requirePointer(type);
+			}
+
+			case Mnemonic::APush:
+			case Mnemonic::ANew:
+			case Mnemonic::AGCNew: {
+				const StackType count = pop();
+				if (mnemonic == Mnemonic::APush) values.push_back(StackType::Array);
+				else values.push_back(mnemonic == Mnemonic::ANew ? StackType::Pointer : StackType::GCPointer);
+				return requireArithmetic(count);
+			}
+			case Mnemonic::Count: {
+				const StackType pointer = pop();
+				values.push_back(StackType::Unknown);
+				return requirePointer(pointer);
+			}
+
+			case Mnemonic::Call: {
+				const auto effect = GetStackEffect(instruction, assembly);
+				values.resize(values.size() - effect->Pops);
+				if (effect->Pushes > 0) {
+					values.push_back(StackType::Unknown);
+				}
+				return std::nullopt;
+			}
+
+			default: return std::nullopt; // Jumps, 'ret', 'nop' and labels
+			}
+		}
+
+		struct DepthMismatch final {
+			std::size_t Instruction = 0;
+			std::size_t Depth = 0;
+			std::size_t OtherDepth = 0;
+		};
+
+		struct StackAnalysis final {
+			std::vector<std::optional<StackState>> States; // Before each instruction. std::nullopt if unreachable.
+			std::vector<DepthMismatch> DepthMismatches;
+		};
+
+		// States are widened until nothing changes. std::nullopt if a callee does not exist.
+		std::optional<StackAnalysis> AnalyzeStack(const Function& function, Assembly& assembly) {
+			const std::vector<Instruction>& instructions = function.Instructions;
+			for (const auto& instruction : instructions) {
+				if (instruction.Mnemonic == Mnemonic::Call && !GetStackEffect(instruction, assembly)) return std::nullopt;
+			}
+
+			std::unordered_map<Symbol, std::size_t> labels; // (Label, Instruction)
+			for (std::size_t i = 0; i < instructions.size(); ++i) {
+				if (instructions[i].Mnemonic == Mnemonic::Label) {
+					labels.emplace(std::get<Symbol>(instructions[i].Operand), i);
+				}
+			}
+
+			StackAnalysis result;
+			result.States.resize(instructions.size());
+			std::vector<char> hasDepthMismatch(instructions.size());
+			std::vector<std::size_t> worklist;
+			const auto visit = [&](std::size_t i, const StackState& state) {
+				if (i == instructions.size()) return;
+
+				std::optional<StackState>& current = result.States[i];
+				bool isChanged = false;
+				if (!current) {
+					current = state;
+					isChanged = true;
+				} else if (!MergeStackState(*current, state, isChanged) && !hasDepthMismatch[i]) {
+					hasDepthMismatch[i] = true;
+					result.DepthMismatches.push_back({ i, current->Values.size(), state.Values.size() });
+				}
+				if (isChanged) {
+					worklist.push_back(i);
+				}
+			};
+
+			if (instructions.empty()) return result;
+			visit(0, StackState{});
+			while (!worklist.empty()) {
+				const std::size_t i = worklist.back();
+				worklist.pop_back();
+
+				const Instruction& instruction = instructions[i];
+				StackState state = *result.States[i];
+				if (ExecuteInstruction(instruction, assembly, state) || instruction.Mnemonic == Mnemonic::Ret) continue;
+
+				if (IsJump(instruction.Mnemonic)) {
+					const auto label = labels.find(std::get<Symbol>(instruction.Operand));
+					if (label == labels.end()) continue; // Reported when lowering
+					else if (instruction.Mnemonic == Mnemonic::Jmp) {
+						visit(label->second, state);
+						continue;
+					}
+
+					StackState takenState = state; // A taken conditional jump pops the result of the comparison
+					takenState.Values.pop_back();
+					visit(label->second, takenState);
+				}
+				visit(i + 1, state);
+			}
+			return result;
+		}
+
+		// Whether any path from the instruction consumes a value that was on the stack before it.
+		// Paths reaching the instruction with different depths only differ in such values, since 'ret' clears the rest of the stack.
+		bool ConsumesStack(const Function& function, Assembly& assembly, std::size_t start) {
+			const std::vector<Instruction>& instructions = function.Instructions;
+
+			std::unordered_map<Symbol, std::size_t> labels; // (Label, Instruction)
+			for (std::size_t i = 0; i < instructions.size(); ++i) {
+				if (instructions[i].Mnemonic == Mnemonic::Label) {
+					labels.emplace(std::get<Symbol>(instructions[i].Operand), i);
+				}
+			}
+
+			// Depths are relative to the start. A smaller depth at the same instruction is all that can consume more.
+			std::vector<std::optional<std::size_t>> depths(instructions.size());
+			std::vector<std::size_t> worklist;
+			const auto visit = [&](std::size_t i, std::size_t depth) {
+				if (i == instructions.size() || (depths[i] && *depths[i] <= depth)) return; // The end of the entrypoint
+
+				depths[i] = depth;
+				worklist.push_back(i);
+			};
+
+			visit(start, 0);
+			while (!worklist.empty()) {
+				const std::size_t i = worklist.back();
+				worklist.pop_back();
+
+				const Instruction& instruction = instructions[i];
+				if (instruction.Mnemonic == Mnemonic::Ret) {
+					if (function.HasResult && *depths[i] == 0) return true;
+					else continue;
+				}
+
+				const auto effect = GetStackEffect(instruction, assembly);
+				if (!effect || *depths[i] < effect->Pops) return true;
+
+				const std::size_t depth = *depths[i] - effect->Pops + effect->Pushes;
+				if (IsJump(instruction.Mnemonic)) {
+					const auto label = labels.find(std::get<Symbol>(instruction.Operand));
+					const std::size_t popCount = instruction.Mnemonic == Mnemonic::Jmp ? 0 : 1;
+					if (label == labels.end()) continue; // Reported when lowering
+					else if (depth < popCount) return true;
+
+					visit(label->second, depth - popCount);
+					if (instruction.Mnemonic == Mnemonic::Jmp) continue;
+				}
+				visit(i + 1, depth);
+			}
+			return false;
+		}
+	}
+
+	std::size_t InlineFunctions(Assembly& assembly, SymbolTable& symbols) {
+		// Bodies are copied before any call is replaced, so a call is inlined only one level deep
+		std::unordered_map<Symbol, InlineCandidate> candidates;
+		for (const auto& function : assembly.Functions) {
+			const auto size = std::count_if(function.Instructions.begin(), function.Instructions.end(), [](const Instruction& instruction) {
+				return instruction.Mnemonic != Mnemonic::Label;
+			});
+			if (!function.IsInline && static_cast<std::size_t>(size) > InlineThreshold) continue;
+			else if (!IsInlinable(function, assembly)) continue;
+
+			InlineCandidate& candidate = candidates[function.Name];
+			candidate.Name = function.Name;
+			for (std::size_t i = 0; i < function.Arity; ++i) {
+				candidate.Parameters.push_back(function.LocalVariables[i].Name);
+			}
+			candidate.Instructions = function.Instructions;
+		}
+		if (candidates.empty()) return 0;
+
+		std::size_t inlinedCount = 0;
+		for (auto& function : assembly.Functions) {
+			// Only the arguments may be on the stack at the call, since the stores of the parameters turn the values on top into local variables
+			const auto depths = GetStackDepths(function, assembly);
+			if (!depths) continue;
+
+			std::vector<Instruction> result;
+			std::size_t callerInlinedCount = 0;
+			for (std::size_t i = 0; i < function.Instructions.size(); ++i) {
+				Instruction& instruction = function.Instructions[i];
+				if (instruction.Mnemonic == Mnemonic::Call) {
+					const Name& name = std::get<Name>(instruction.Operand);
+					const auto callee = name.NameSpace == Symbol::Empty && name.Identifier != function.Name ?
+						candidates.find(name.Identifier) : candidates.end();
+					if (callee != candidates.end() && (*depths)[i] == callee->second.Parameters.size()) {
+						const Symbol prefix = symbols.Concat(callee->first, symbols.Intern(std::to_string(callerInlinedCount++)));
+						InlineCall(function, callee->second, prefix, instruction.Token, symbols, result);
+						continue;
+					}
+				}
+				result.push_back(std::move(instruction));
+			}
+
+			function.Instructions = std::move(result);
+			inlinedCount += callerInlinedCount;
+		}
+		return inlinedCount;
+	}
+
+	std::size_t EliminateTailCalls(Function& function, Assembly& assembly, SymbolTable& symbols) {
+		const std::vector<Instruction>& instructions = function.Instructions;
+		if (function.Name == Symbol::Entrypoint) return 0; // Reported when lowering
+
+		const auto isTailCall = [&](std::size_t i) {
+			if (instructions[i].Mnemonic != Mnemonic::Call) return false;
+
+			const Name& name = std::get<Name>(instructions[i].Operand);
+			if (name.NameSpace != Symbol::Empty || name.Identifier != function.Name) return false;
+
+			while (++i < instructions.size() && instructions[i].Mnemonic == Mnemonic::Label);
+			return i < instructions.size() && instructions[i].Mnemonic == Mnemonic::Ret;
+		};
+
+		std::vector<std::size_t> tailCalls;
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			if (isTailCall(i)) {
+				tailCalls.push_back(i);
+			}
+		}
+		if (tailCalls.empty()) return 0;
+
+		// Only the arguments may be on the stack at the call, since nothing else would be dropped when jumping back
+		const auto depths = GetStackDepths(function, assembly);
+		if (!depths) return 0;
+
+		tailCalls.erase(std::remove_if(tailCalls.begin(), tailCalls.end(), [&](std::size_t i) {
+			return (*depths)[i] && *(*depths)[i] != function.Arity;
+		}), tailCalls.end());
+		if (tailCalls.empty()) return 0;
+
+		// '<function>.entry' cannot be written in the source
+		const Symbol entry = symbols.Concat(function.Name, symbols.Intern("entry"));
+		function.AddLabel(Label{ entry });
+
+		std::vector<Instruction> result;
+		result.reserve(instructions.size() + tailCalls.size() * function.Arity + 1);
+		result.push_back({ Mnemonic::Label, entry, instructions.front().Token });
+
+		auto tailCall = tailCalls.begin();
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			if (tailCall == tailCalls.end() || *tailCall != i) {
+				result.push_back(std::move(function.Instructions[i]));
+				continue;
+			}
+
+			// Arguments are on the stack with the first one on top
+			const std::size_t token = instructions[i].Token;
+			for (std::size_t j = 0; j < function.Arity; ++j) {
+				result.push_back({ Mnemonic::Store, function.LocalVariables[j].Name, token });
+			}
+			result.push_back({ Mnemonic::Jmp, entry, token });
+
+			if (instructions[i + 1].Mnemonic == Mnemonic::Ret) {
+				++i;
+			}
+			++tailCall;
+		}
+
+		function.Instructions = std::move(result);
+		return tailCalls.size();
+	}
+	std::size_t SimplifyControlFlow(Function& function, Assembly& assembly) {
+		std::vector<Instruction>& instructions = function.Instructions;
+
+		std::unordered_map<Symbol, std::size_t> labels; // (Label, Instruction)
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			if (instructions[i].Mnemonic == Mnemonic::Label) {
+				labels.emplace(std::get<Symbol>(instructions[i].Operand), i);
+			}
+		}
+		const auto skipLabels = [&instructions](std::size_t i) {
+			while (i < instructions.size() && instructions[i].Mnemonic == Mnemonic::Label) {
+				++i;
+			}
+			return i;
+		};
+
+		// Jumps to unconditional jumps go to their final destination
+		for (auto& instruction : instructions) {
+			if (!IsJump(instruction.Mnemonic)) continue;
+
+			Symbol& target = std::get<Symbol>(instruction.Operand);
+			std::unordered_set<Symbol> visitedTargets{ target };
+			while (true) {
+				const auto label = labels.find(target);
+				if (label == labels.end()) break; // Reported when lowering
+
+				const std::size_t next = skipLabels(label->second);
+				if (next == instructions.size() || instructions[next].Mnemonic != Mnemonic::Jmp) break;
+
+				const Symbol nextTarget = std::get<Symbol>(instructions[next].Operand);
+				if (!visitedTargets.insert(nextTarget).second) break; // Infinite loop
+				target = nextTarget;
+			}
+		}
+
+		const auto blocks = BuildControlFlowGraph(function);
+		if (!blocks || blocks->empty()) return 0;
+
+		std::vector<char> isReachable(blocks->size());
+		std::vector<std::size_t> worklist{ 0 };
+		isReachable[0] = true;
+		while (!worklist.empty()) {
+			const BasicBlock& block = (*blocks)[worklist.back()];
+			worklist.pop_back();
+
+			for (const std::size_t successor : block.Successors) {
+				if (!isReachable[successor]) {
+					isReachable[successor] = true;
+					worklist.push_back(successor);
+				}
+			}
+		}
+
+		// Unreachable blocks are dropped unless lowering them would report an error or declare a local variable for the code after them.
+		// Their labels are kept, since they are already reserved in the builder.
+		std::unordered_set<Symbol> declaredLocalVariables;
+		for (std::size_t i = 0; i < function.Arity; ++i) {
+			declaredLocalVariables.insert(function.LocalVariables[i].Name);
+		}
+
+		std::vector<char> isRemoved(instructions.size());
+		for (std::size_t i = 0; i < blocks->size(); ++i) {
+			const BasicBlock& block = (*blocks)[i];
+
+			bool isRemovable = !isReachable[i];
+			for (std::size_t j = block.Begin; j < block.End; ++j) {
+				const Instruction& instruction = instructions[j];
+				if (instruction.Mnemonic == Mnemonic::Label) continue;
+				else if (instruction.Mnemonic == Mnemonic::Store || instruction.Mnemonic == Mnemonic::String32) {
+					isRemovable &= !declaredLocalVariables.insert(*GetLocalVariableOperand(instruction)).second;
+				} else if (const auto localVariable = GetLocalVariableOperand(instruction)) {
+					isRemovable &= declaredLocalVariables.count(*localVariable) != 0;
+				}
+				isRemovable &= CanLower(instruction, assembly, labels);
+			}
+			if (!isRemovable) continue;
+
+			for (std::size_t j = block.Begin; j < block.End; ++j) {
+				isRemoved[j] = instructions[j].Mnemonic != Mnemonic::Label;
+			}
+		}
+
+		// Unconditional jumps to the label right after them. A taken conditional jump pops the result of the comparison, so those stay.
+		const auto jumpsToNext = [&](std::size_t i) {
+			const Symbol target = std::get<Symbol>(instructions[i].Operand);
+			for (++i; i < instructions.size() && (isRemoved[i] || instructions[i].Mnemonic == Mnemonic::Label); ++i) {
+				if (!isRemoved[i] && std::get<Symbol>(instructions[i].Operand) == target) return true;
+			}
+			return false;
+		};
+
+		std::vector<Instruction> result;
+		result.reserve(instructions.size());
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			if (isRemoved[i] || (instructions[i].Mnemonic == Mnemonic::Jmp && jumpsToNext(i))) continue;
+
+			result.push_back(std::move(instructions[i]));
+		}
+
+		const std::size_t eliminatedCount = instructions.size() - result.size();
+		instructions = std::move(result);
+		return eliminatedCount;
+	}
+	std::size_t FoldConstants(Function& function) {
+		std::vector<Instruction> result;
+		result.reserve(function.Instructions.size());
+		for (auto& instruction : function.Instructions) {
+			if (!result.empty()) {
+				if (const auto operand = GetConstant(result.back())) {
+					if (const auto value = FoldUnary(instruction.Mnemonic, *operand)) {
+						result.back().Operand = ToOperand(*value);
+						continue;
+					} else if (result.size() >= 2) {
+						if (const auto lhs = GetConstant(result[result.size() - 2])) {
+							if (const auto value = FoldBinary(instruction.Mnemonic, *lhs, *operand)) {
+								result.pop_back();
+								result.back().Operand = ToOperand(*value);
+								continue;
+							}
+						}
+					}
+				}
+			}
+			result.push_back(std::move(instruction));
+		}
+
+		const std::size_t eliminatedCount = function.Instructions.size() - result.size();
+		function.Instructions = std::move(result);
+		return eliminatedCount;
+	}
+	std::size_t OptimizePeephole(Function& function) {
+		// Local variables that are read anywhere in the function, and how many times
+		std::unordered_map<Symbol, std::size_t> readCounts;
+		for (const auto& instruction : function.Instructions) {
+			if (instruction.Mnemonic == Mnemonic::Store) continue;
+			if (const auto localVariable = GetLocalVariableOperand(instruction)) {
+				++readCounts[*localVariable];
+			}
+		}
+
+		// Local variables declared so far. Instructions referring to undeclared ones are kept, so that lowering still reports them.
+		std::unordered_set<Symbol> declaredLocalVariables;
+		for (const auto& localVariable : function.LocalVariables) {
+			declaredLocalVariables.insert(localVariable.Name);
+		}
+
+		const auto isDeclared = [&declaredLocalVariables](const Instruction& instruction) {
+			return declaredLocalVariables.find(std::get<Symbol>(instruction.Operand)) != declaredLocalVariables.end();
+		};
+		const auto isRedundantPair = [&](const Instruction& first, const Instruction& second) {
+			switch (second.Mnemonic) {
+			case Mnemonic::Pop:
+				// Pushes without side effects followed by pop
+				switch (first.Mnemonic) {
+				case Mnemonic::Push: return IsNumberOperand(first.Operand);
+				case Mnemonic::Load:
+				case Mnemonic::Lea: return isDeclared(first);
+				case Mnemonic::Copy: return true;
+				default: return false;
+				}
+
+			case Mnemonic::Swap:
+			case Mnemonic::Neg:
+			case Mnemonic::Not:
+				return first.Mnemonic == second.Mnemonic;
+
+			case Mnemonic::Load:
+				// store x, load x where x is never read again
+				return first.Mnemonic == Mnemonic::Store && std::get<Symbol>(first.Operand) == std::get<Symbol>(second.Operand) &&
+					readCounts[std::get<Symbol>(second.Operand)] == 1;
+
+			default:
+				return false;
+			}
+		};
+
+		std::vector<Instruction> result;
+		result.reserve(function.Instructions.size());
+		for (auto& instruction : function.Instructions) {
+			if (instruction.Mnemonic == Mnemonic::Store || instruction.Mnemonic == Mnemonic::String32) {
+				declaredLocalVariables.insert(*GetLocalVariableOperand(instruction));
+			}
+
+			if (!result.empty() && isRedundantPair(result.back(), instruction)) {
+				result.pop_back();
+			} else {
+				result.push_back(std::move(instruction));
+			}
+		}
+
+		const std::size_t eliminatedCount = function.Instructions.size() - result.size();
+		function.Instructions = std::move(result);
+		return eliminatedCount;
+	}
+	std::size_t ShareLocalVariables(Function& function, Assembly& assembly) {
+		std::vector<Instruction>& instructions = function.Instructions;
+		const auto analysis = AnalyzeStack(function, assembly);
+		const auto blocks = BuildControlFlowGraph(function);
+		if (!analysis || !analysis->DepthMismatches.empty() || !blocks) return 0;
+
+		// Parameters, and local variables whose slots cannot be shared safely
+		const std::vector<std::optional<StackState>>& states = analysis->States;
+		std::unordered_set<Symbol> excluded;
+		for (const auto& localVariable : function.LocalVariables) {
+			excluded.insert(localVariable.Name);
+		}
+
+		// Candidates in order of first appearance, with the type of the values stored into them and their declaring stores
+		std::vector<Symbol> candidates;
+		std::unordered_map<Symbol, StackType> types;
+		std::unordered_map<Symbol, std::size_t> declarations;
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			const Instruction& instruction = instructions[i];
+			if (instruction.Mnemonic == Mnemonic::Pop && (!states[i] || states[i]->Values.empty())) return 0; // May delete the last local variable
+
+			const auto localVariable = GetLocalVariableOperand(instruction);
+			if (!localVariable || excluded.count(*localVariable)) continue;
+
+			bool isSharable = true;
+			if (instruction.Mnemonic == Mnemonic::Store) {
+				declarations.emplace(*localVariable, i);
+
+				const StackType type = states[i] && !states[i]->Values.empty() ? states[i]->Values.back() : StackType::Unknown;
+				const auto [iter, isInserted] = types.emplace(*localVariable, type);
+				isSharable = type != StackType::Unknown && type <= StackType::GCPointer && (isInserted || iter->second == type);
+			} else if (declarations.find(*localVariable) == declarations.end()) {
+				isSharable = false; // Used before the first store in instruction order, which lowering has to report
+			} else if (instruction.Mnemonic == Mnemonic::Lea) {
+				// Only addresses taken to increase or decrease the value in place, which cannot escape
+				const Mnemonic next = i + 1 < instructions.size() ? instructions[i + 1].Mnemonic : Mnemonic::None;
+				isSharable = next == Mnemonic::Inc || next == Mnemonic::Dec;
+			} else if (instruction.Mnemonic == Mnemonic::String32) {
+				isSharable = false;
+			}
+
+			if (!isSharable) {
+				excluded.insert(*localVariable);
+			} else if (std::find(candidates.begin(), candidates.end(), *localVariable) == candidates.end()) {
+				candidates.push_back(*localVariable);
+			}
+		}
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](Symbol name) {
+			return excluded.count(name) || !types.count(name);
+		}), candidates.end());
+		if (candidates.size() < 2) return 0;
+
+		std::unordered_map<Symbol, std::size_t> indices; // (Local variable, Candidate)
+		for (std::size_t i = 0; i < candidates.size(); ++i) {
+			indices.emplace(candidates[i], i);
+		}
+		const auto getIndex = [&](const Instruction& instruction) -> std::optional<std::size_t> {
+			const auto localVariable = GetLocalVariableOperand(instruction);
+			if (!localVariable) return std::nullopt;
+
+			const auto iter = indices.find(*localVariable);
+			if (iter == indices.end()) return std::nullopt;
+			else return iter->second;
+		};
+
+		// Candidates live at the start and the end of each block, widened until nothing changes
+		const std::size_t count = candidates.size();
+		std::vector<std::vector<char>> liveIns(blocks->size(), std::vector<char>(count));
+		std::vector<std::vector<char>> liveOuts(blocks->size(), std::vector<char>(count));
+		for (bool isChanged = true; isChanged;) {
+			isChanged = false;
+			for (std::size_t i = blocks->size(); i-- > 0;) {
+				const BasicBlock& block = (*blocks)[i];
+				std::vector<char>& liveOut = liveOuts[i];
+				for (const std::size_t successor : block.Successors) {
+					for (std::size_t j = 0; j < count; ++j) {
+						liveOut[j] |= liveIns[successor][j];
+					}
+				}
+
+				std::vector<char> live = liveOut;
+				for (std::size_t j = block.End; j-- > block.Begin;) {
+					if (const auto index = getIndex(instructions[j])) {
+						live[*index] = instructions[j].Mnemonic != Mnemonic::Store; // 'lea' reads the value before 'inc' or 'dec' writes it
+					}
+				}
+				if (live != liveIns[i]) {
+					liveIns[i] = std::move(live);
+					isChanged = true;
+				}
+			}
+		}
+
+		// A store interferes with everything live after it, and everything live on entry is unassigned at the same time
+		std::vector<std::vector<char>> interferences(count, std::vector<char>(count));
+		const auto interfere = [&](std::size_t index, const std::vector<char>& live) {
+			for (std::size_t j = 0; j < count; ++j) {
+				if (j != index && live[j]) {
+					interferences[index][j] = interferences[j][index] = true;
+				}
+			}
+		};
+		for (std::size_t i = 0; i < blocks->size(); ++i) {
+			const BasicBlock& block = (*blocks)[i];
+			std::vector<char> live = liveOuts[i];
+			for (std::size_t j = block.End; j-- > block.Begin;) {
+				const auto index = getIndex(instructions[j]);
+				if (!index) continue;
+				else if (instructions[j].Mnemonic == Mnemonic::Store) {
+					interfere(*index, live);
+					live[*index] = false;
+				} else {
+					live[*index] = true;
+				}
+			}
+		}
+		for (std::size_t i = 0; i < count && !blocks->empty(); ++i) {
+			if (liveIns[0][i]) {
+				interfere(i, liveIns[0]);
+			}
+		}
+
+		// Each candidate takes the first slot of the same type whose local variables it does not interfere with
+		std::vector<std::size_t> slots(count);
+		std::vector<std::vector<std::size_t>> slotMembers;
+		for (std::size_t i = 0; i < count; ++i) {
+			slots[i] = slotMembers.size();
+			for (std::size_t j = 0; j < slotMembers.size(); ++j) {
+				const std::vector<std::size_t>& members = slotMembers[j];
+				if (types[candidates[members.front()]] != types[candidates[i]]) continue;
+				else if (declarations[candidates[members.front()]] > declarations[candidates[i]]) continue; // Would move the declaring store of the slot
+				else if (std::any_of(members.begin(), members.end(), [&](std::size_t member) { return interferences[i][member]; })) continue;
+
+				slots[i] = j;
+				break;
+			}
+			if (slots[i] == slotMembers.size()) {
+				slotMembers.emplace_back();
+			}
+			slotMembers[slots[i]].push_back(i);
+		}
+
+		for (auto& instruction : instructions) {
+			if (const auto index = getIndex(instruction)) {
+				instruction.Operand = candidates[slotMembers[slots[*index]].front()];
+			}
+		}
+		return count - slotMembers.size();
+	}
+
+	void LayOutBlocks(Function& function, std::optional<std::uint64_t> entryCount, const std::unordered_map<Symbol, std::uint64_t>& labelCounts, SymbolTable& symbols) {
+		std::vector<Instruction>& instructions = function.Instructions;
+
+		const auto blocks = BuildControlFlowGraph(function);
+		if (!blocks || blocks->size() <= 1) return;
+
+		std::unordered_map<Symbol, std::size_t> labelBlocks; // (Label, Block)
+		for (std::size_t i = 0; i < blocks->size(); ++i) {
+			const Instruction& first = instructions[(*blocks)[i].Begin];
+			if (first.Mnemonic == Mnemonic::Label) {
+				labelBlocks.emplace(std::get<Symbol>(first.Operand), i);
+			}
+		}
+		const auto fallsThrough = [&](std::size_t i) {
+			const Mnemonic last = instructions[(*blocks)[i].End - 1].Mnemonic;
+			return last != Mnemonic::Ret && last != Mnemonic::Jmp;
+		};
+
+		// Blocks without a count of their own take the count of the block falling through to them, less what its conditional jump took
+		std::vector<std::uint64_t> weights(blocks->size());
+		for (std::size_t i = 0; i < blocks->size(); ++i) {
+			const Instruction& first = instructions[(*blocks)[i].Begin];
+			const auto count = first.Mnemonic == Mnemonic::Label ? labelCounts.find(std::get<Symbol>(first.Operand)) : labelCounts.end();
+			if (count != labelCounts.end()) {
+				weights[i] = count->second;
+			} else if (i == 0) {
+				weights[i] = entryCount.value_or(0);
+			} else if (fallsThrough(i - 1)) {
+				weights[i] = weights[i - 1];
+
+				const Instruction& last = instructions[(*blocks)[i - 1].End - 1];
+				const auto taken = IsJump(last.Mnemonic) ? labelCounts.find(std::get<Symbol>(last.Operand)) : labelCounts.end();
+				if (taken != labelCounts.end()) {
+					weights[i] -= std::min(weights[i], taken->second);
+				}
+			}
+		}
+
+		// The entry block stays first, and a last block that runs off the end of the function stays last.
+		// Each block is followed by its hottest unplaced successor, preferring the one it falls through to; when there is none, the hottest
+		// unplaced block starts a new chain, so blocks that never ran end up at the tail.
+		const std::size_t pinnedLast = fallsThrough(blocks->size() - 1) ? blocks->size() - 1 : blocks->size();
+		std::vector<char> isPlaced(blocks->size());
+		std::vector<std::size_t> order{ 0 };
+		isPlaced[0] = true;
+		if (pinnedLast < blocks->size()) {
+			isPlaced[pinnedLast] = true;
+		}
+
+		const auto isHotter = [&](std::size_t candidate, std::size_t best, std::size_t fallThrough) {
+			if (best == blocks->size()) return true;
+			else if (weights[candidate] != weights[best]) return weights[candidate] > weights[best];
+			else if (candidate == fallThrough || best == fallThrough) return candidate == fallThrough;
+			else return candidate < best;
+		};
+		while (order.size() + (pinnedLast < blocks->size()) < blocks->size()) {
+			const std::size_t current = order.back();
+
+			std::size_t hottest = blocks->size();
+			for (std::size_t i = 0; i < blocks->size(); ++i) {
+				if (!isPlaced[i] && isHotter(i, hottest, blocks->size())) {
+					hottest = i;
+				}
+			}
+
+			std::size_t next = blocks->size();
+			const std::size_t fallThrough = fallsThrough(current) ? current + 1 : blocks->size();
+			for (const std::size_t successor : (*blocks)[current].Successors) {
+				if (!isPlaced[successor] && isHotter(successor, next, fallThrough)) {
+					next = successor;
+				}
+			}
+			if (next == blocks->size() || (weights[next] == 0 && weights[hottest] > 0)) {
+				next = hottest;
+			}
+
+			order.push_back(next);
+			isPlaced[next] = true;
+		}
+		if (pinnedLast < blocks->size()) {
+			order.push_back(pinnedLast);
+		}
+
+		bool isIdentity = true;
+		for (std::size_t i = 0; i < order.size(); ++i) {
+			isIdentity &= order[i] == i;
+		}
+		if (isIdentity) return;
+
+		// Local variables are declared by their first store in instruction order, so every other use must still come after it
+		std::unordered_set<Symbol> declaredLocalVariables;
+		for (std::size_t i = 0; i < function.Arity; ++i) {
+			declaredLocalVariables.insert(function.LocalVariables[i].Name);
+		}
+		for (const std::size_t i : order) {
+			for (std::size_t j = (*blocks)[i].Begin; j < (*blocks)[i].End; ++j) {
+				const Instruction& instruction = instructions[j];
+				if (instruction.Mnemonic == Mnemonic::Store || instruction.Mnemonic == Mnemonic::String32) {
+					declaredLocalVariables.insert(*GetLocalVariableOperand(instruction));
+				} else if (const auto localVariable = GetLocalVariableOperand(instruction)) {
+					if (declaredLocalVariables.count(*localVariable) == 0) return;
+				}
+			}
+		}
+
+		// '<function>.block<n>' cannot be written in the source
+		std::vector<Symbol> labels(blocks->size());
+		const auto getLabel = [&](std::size_t i) {
+			const Instruction& first = instructions[(*blocks)[i].Begin];
+			if (first.Mnemonic == Mnemonic::Label) return std::get<Symbol>(first.Operand);
+			else if (labels[i] == Symbol::Empty) {
+				labels[i] = symbols.Concat(function.Name, symbols.Intern("block" + std::to_string(i)));
+				function.AddLabel(Label{ labels[i] });
+			}
+			return labels[i];
+		};
+		for (std::size_t i = 0; i + 1 < order.size(); ++i) {
+			const std::size_t block = order[i];
+			if (fallsThrough(block) && block + 1 < blocks->size() && order[i + 1] != block + 1) {
+				getLabel(block + 1);
+			}
+		}
+
+		std::vector<Instruction> result;
+		result.reserve(instructions.size() + blocks->size());
+		for (std::size_t i = 0; i < order.size(); ++i) {
+			const BasicBlock& block = (*blocks)[order[i]];
+			const std::size_t next = i + 1 < order.size() ? order[i + 1] : blocks->size();
+			if (labels[order[i]] != Symbol::Empty) {
+				result.push_back({ Mnemonic::Label, labels[order[i]], instructions[block.Begin].Token });
+			}
+			for (std::size_t j = block.Begin; j < block.End; ++j) {
+				result.push_back(instructions[j]);
+			}
+
+			const Instruction& last = result.back();
+			const auto target = last.Mnemonic == Mnemonic::Jmp ? labelBlocks.find(std::get<Symbol>(last.Operand)) : labelBlocks.end();
+			if (target != labelBlocks.end() && target->second == next) {
+				result.pop_back();
+			} else if (fallsThrough(order[i]) && order[i] + 1 < blocks->size() && next != order[i] + 1) {
+				// Conditional jumps are not inverted, since only a taken one pops the result of the comparison
+				result.push_back({ Mnemonic::Jmp, getLabel(order[i] + 1), last.Token });
+			}
+		}
+
+		instructions = std::move(result);
+	}
+
+	std::pair<std::size_t, std::size_t> EliminateUnusedSections(Assembly& assembly, const std::vector<Symbol>& roots) {
+		std::vector<char> isFunctionUsed(assembly.Functions.size());
+		std::vector<char> isStructureUsed(assembly.Structures.size());
+		std::vector<std::size_t> functionQueue, structureQueue;
+
+		const auto useFunction = [&](Symbol name) {
+			const auto function = assembly.FindFunction(name);
+			if (function == assembly.Functions.end()) return;
+
+			const auto index = static_cast<std::size_t>(function - assembly.Functions.begin());
+			if (!isFunctionUsed[index]) {
+				isFunctionUsed[index] = true;
+				functionQueue.push_back(index);
+			}
+		};
+		const auto useStructure = [&](const Name& name) {
+			if (name.NameSpace != Symbol::Empty) return;
+
+			const auto structure = assembly.FindStructure(name.Identifier);
+			if (structure == assembly.Structures.end()) return;
+
+			const auto index = static_cast<std::size_t>(structure - assembly.Structures.begin());
+			if (!isStructureUsed[index]) {
+				isStructureUsed[index] = true;
+				structureQueue.push_back(index);
+			}
+		};
+
+		// Call graph rooted at entrypoint and the given roots; structures are used by operands of reachable code and by fields of used structures
+		useFunction(Symbol::Entrypoint);
+		for (const Symbol root : roots) {
+			useFunction(root);
+			useStructure(Name{ Symbol::Empty, root, Symbol::Empty, root });
+		}
+		while (!functionQueue.empty()) {
+			const Function& function = assembly.Functions[functionQueue.back()];
+			functionQueue.pop_back();
+
+			for (const auto& instruction : function.Instructions) {
+				if (std::holds_alternative<Type>(instruction.Operand)) {
+					useStructure(std::get<Type>(instruction.Operand).ElementTypeName);
+				} else if (std::holds_alternative<Name>(instruction.Operand)) {
+					const Name& name = std::get<Name>(instruction.Operand);
+					if (instruction.Mnemonic != Mnemonic::Call) {
+						useStructure(name);
+					} else if (name.NameSpace == Symbol::Empty) {
+						useFunction(name.Identifier);
+					}
+				}
+			}
+		}
+		while (!structureQueue.empty()) {
+			const Structure& structure = assembly.Structures[structureQueue.back()];
+			structureQueue.pop_back();
+
+			for (const auto& field : structure.Fields) {
+				useStructure(field.Type.ElementTypeName);
+			}
+		}
+
+		std::vector<Function> functions = std::move(assembly.Functions);
+		assembly.Functions.clear();
+		assembly.FunctionNames = NameIndex();
+		for (std::size_t i = 0; i < functions.size(); ++i) {
+			if (isFunctionUsed[i]) {
+				assembly.AddFunction(std::move(functions[i]));
+			}
+		}
+
+		std::vector<Structure> structures = std::move(assembly.Structures);
+		assembly.Structures.clear();
+		assembly.StructureNames = NameIndex();
+		for (std::size_t i = 0; i < structures.size(); ++i) {
+			if (isStructureUsed[i]) {
+				assembly.AddStructure(std::move(structures[i]));
+			}
+		}
+
+		return { functions.size() - assembly.Functions.size(), structures.size() - assembly.Structures.size() };
+	}
+
+	StackInfo VerifyStack(const Function& function, Assembly& assembly) {
+		const std::vector<Instruction>& instructions = function.Instructions;
+		const auto analysis = AnalyzeStack(function, assembly);
+		if (!analysis) return {}; // Reported when lowering
+
+		// Paths reaching an instruction with different depths are allowed, since 'ret' clears the stack, but then the depth has no bound
+		StackInfo result;
+		const std::vector<std::optional<StackState>>& states = analysis->States;
+		for (const auto& mismatch : analysis->DepthMismatches) {
+			if (!ConsumesStack(function, assembly, mismatch.Instruction)) continue;
+
+			result.Messages.push_back({ mismatch.Instruction, false, "Different stack depths " + std::to_string(mismatch.Depth) + " and " +
+				std::to_string(mismatch.OtherDepth) + " between paths" });
+		}
+
+		// Checked once the states are final, so that each instruction is reported at most once
+		std::size_t maxDepth = 0;
+		for (std::size_t i = 0; i < instructions.size(); ++i) {
+			if (!states[i]) continue; // Unreachable
+
+			const Instruction& instruction = instructions[i];
+			StackState state = *states[i];
+			maxDepth = std::max(maxDepth, state.Values.size());
+			if (auto error = ExecuteInstruction(instruction, assembly, state)) {
+				result.Messages.push_back({ i, true, std::move(*error) });
+				continue;
+			}
+			maxDepth = std::max(maxDepth, state.Values.size());
+
+			if (instruction.Mnemonic == Mnemonic::Ret && function.HasResult && state.Values.empty()) {
+				result.Messages.push_back({ i, true, "Required return value before 'ret'" });
+			} else if (i + 1 == instructions.size() && instruction.Mnemonic != Mnemonic::Ret && instruction.Mnemonic != Mnemonic::Jmp &&
+				function.Name != Symbol::Entrypoint) {
+				result.Messages.push_back({ i, true, "Required 'ret' at the end of function" });
+			}
+		}
+
+		std::stable_sort(result.Messages.begin(), result.Messages.end(), [](const auto& a, const auto& b) {
+			return a.Instruction < b.Instruction;
+		});
+		if (analysis->DepthMismatches.empty()) {
+			result.MaxDepth = maxDepth;
+		}
+		return result;
+	}
+}
\ No newline at end of file
@@ -1,24 +1,38 @@
 #include <sam/Parser.hpp>
 
 #include <sam/ExternModule.hpp>
-#include <sam/String.hpp>
+#include <sam/Mnemonic.hpp>
+#include <sam/Optimizer.hpp>
+#include <sam/Profile.hpp>
 #include <sgn/ByteFile.hpp>
 #include <svm/Type.hpp>
 
 #include <algorithm>
-#include <cctype>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <iterator>
 #include <limits>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 
 namespace sam {
-	Parser::Parser(const std::vector<const char*>& importDirectories,
-		std::string path, std::vector<Token> tokens, int depth) noexcept
-		: m_ImportDirectories(importDirectories), m_Path(std::move(path)), m_Tokens(std::move(tokens)), m_Depth(depth) {}
+	namespace {
+		const std::unordered_map<std::string_view, sgn::Type>& GetFundamentalTypes() {
+			static const std::unordered_map<std::string_view, sgn::Type> fundamental = {
+				{ "int", sgn::IntType },
+				{ "long", sgn::LongType },
+				{ "single", sgn::SingleType },
+				{ "double", sgn::DoubleType },
+				{ "pointer", sgn::PointerType },
+				{ "gcpointer", sgn::GCPointerType },
+			};
+			return fundamental;
+		}
+	}
+
+	Parser::Parser(Context& context,
+		std::string path, std::shared_ptr<const Source> source, std::vector<Token> tokens, int depth) noexcept
+		: m_Context(context), m_Path(std::move(path)), m_Source(std::move(source)), m_Tokens(std::move(tokens)), m_Depth(depth) {}
 
 #define CURRENT_TOKEN (&GetToken(m_Token))
 
@@ -27,21 +41,102 @@ namespace sam {
 #define WARNING (m_HasWarning = true, MESSAGEBASE) << "Warning: Line " << CURRENT_TOKEN->Line << ", "
 #define ERROR (m_HasError = true, MESSAGEBASE) << "Error: Line " << CURRENT_TOKEN->Line << ", "
 
+// Functions are lowered on the thread pool, so their messages go to the state of the function
+#define STATE_MESSAGEBASE state.Messages << "In file '" << *state.Path << "':\n    "
+#define STATE_WARNING (state.HasWarning = true, STATE_MESSAGEBASE) << "Warning: Line " << GetToken(state).Line << ", "
+#define STATE_ERROR (state.HasError = true, STATE_MESSAGEBASE) << "Error: Line " << GetToken(state).Line << ", "
+
 	void Parser::Parse() {
-		if (!FirstPass() || m_Depth > 1) return; // Prototypes
-		ResetState();
+		if (m_Context.UseMultiPass) {
+			if (!FirstPass() || IsPrototypeOnly()) return; // Prototypes
+			ResetState();
 
-		if (!SecondPass()) return; // Dependencies
-		ResetState();
+			const bool isParsed = SecondPass();
+			if (!ResolveImports() || !isParsed) return; // Dependencies
+			LinkModules();
+			ResetState();
 
-		if (!ThirdPass() || m_Depth > 0) return; // Strucutre fields
+			if (!ThirdPass() || (m_Depth > 0 && !m_Context.UseStaticLinking)) return; // Strucutre fields
+			ResetState();
+
+			if (!FourthPass() || m_Depth > 0) return; // Function instructions
+		} else {
+			const bool isParsed = SinglePass();
+			if (!ResolveImports() || !isParsed || IsPrototypeOnly()) return; // Prototypes, dependencies and function instructions
+			LinkModules();
+			ResetState();
+
+			if (!ResolveFields() || m_Depth > 0) return; // Structure fields
+		}
 		ResetState();
 
-		FourthPass(); // Function instructions
+		if (m_Context.UseGcSections || IsLinkedStatically()) {
+			RemoveUnusedSections();
+		}
+		if (m_Context.Profile) {
+			SortFunctionsByProfile();
+		}
+		EmitInstructions();
+	}
+	bool Parser::Load(const ModuleInterface& interface) {
+		for (const auto& structure : interface.Structures) {
+			const sgn::StructureIndex index = m_Result.ByteFile.AddStructure(structure.Name);
+			m_Result.AddStructure(Structure{ m_Context.Symbols.Intern(structure.Name), index });
+		}
+		for (const auto& function : interface.Functions) {
+			const Symbol name = m_Context.Symbols.Intern(function.Name);
+			sgn::FunctionIndex index = sgn::FunctionIndex::OperandIndex/*Dummy*/;
+			if (name != Symbol::Entrypoint) {
+				index = m_Result.ByteFile.AddFunction(function.Name, function.Arity, function.HasResult);
+			}
+			m_Result.AddFunction(Function{ nullptr, name, index, function.Arity, function.HasResult });
+		}
+		if (IsPrototypeOnly()) return true;
+
+		for (const auto& import : interface.Imports) {
+			const Symbol nameSpace = m_Context.Symbols.Intern(import.NameSpace);
+			if (ParseExternModule(Name{ nameSpace, Symbol::Empty, Symbol::Empty, nameSpace }, import.Path)) return false;
+		}
+		if (!ResolveImports()) return false;
+
+		for (std::size_t i = 0; i < interface.Structures.size(); ++i) {
+			Structure& structure = m_Result.Structures[i];
+			sgn::StructureInfo* const structureInfo = m_Result.ByteFile.GetStructureInfo(structure.Index);
+
+			for (const auto& field : interface.Structures[i].Fields) {
+				const Type type{ MakeName(field.TypeName), field.ElementCount };
+				const sgn::Type elementType = GetType(type.ElementTypeName);
+				if (elementType == nullptr) return false; // An import has changed since the interface was stored
+
+				const sgn::FieldIndex index = structureInfo->AddField(elementType, field.ElementCount.value_or(0));
+				structure.AddField(Field{ m_Context.Symbols.Intern(field.Name), index, type });
+			}
+		}
+		return true;
 	}
 	Assembly Parser::GetAssembly() noexcept {
 		return std::move(m_Result);
 	}
+	ModuleInterface Parser::GetInterface() const {
+		ModuleInterface result;
+		result.IsComplete = m_Depth <= 1;
+
+		for (const auto& dependency : m_Result.Dependencies) {
+			result.Imports.push_back({ dependency.ImportPath, std::string(GetString(dependency.NameSpace)) });
+		}
+		for (const auto& structure : m_Result.Structures) {
+			auto& structureInterface = result.Structures.emplace_back();
+			structureInterface.Name = GetString(structure.Name);
+			for (const auto& field : structure.Fields) {
+				structureInterface.Fields.push_back({ std::string(GetString(field.Name)),
+					std::string(GetString(field.Type.ElementTypeName.Full)), field.Type.ElementCount });
+			}
+		}
+		for (const auto& function : m_Result.Functions) {
+			result.Functions.push_back({ std::string(GetString(function.Name)), function.Arity, function.HasResult });
+		}
+		return result;
+	}
 
 	bool Parser::HasError() const noexcept {
 		return m_HasError;
@@ -53,6 +148,13 @@ namespace sam {
 		return m_ErrorStream.str();
 	}
 
+	bool Parser::IsPrototypeOnly() const noexcept {
+		// Bodies of every imported module are needed for static linking
+		return m_Depth > 1 && !m_Context.UseStaticLinking;
+	}
+	bool Parser::IsLinkedStatically() const noexcept {
+		return m_Context.UseStaticLinking && m_Depth == 0;
+	}
 	void Parser::ResetState() noexcept {
 		m_Token = 0;
 		m_CurrentStructure = nullptr;
@@ -62,6 +164,15 @@ namespace sam {
 		if (i >= m_Tokens.size()) return m_EmptyToken;
 		else return m_Tokens[i];
 	}
+	std::string_view Parser::GetString(Symbol symbol) const noexcept {
+		return m_Context.Symbols.GetString(symbol);
+	}
+	Name Parser::MakeName(std::string_view full) {
+		const Symbol fullSymbol = m_Context.Symbols.Intern(full);
+		const std::size_t lastDot = full.find_last_of('.');
+		if (lastDot == std::string_view::npos) return Name{ Symbol::Empty, fullSymbol, Symbol::Empty, fullSymbol };
+		else return Name{ m_Context.Symbols.Intern(full.substr(0, lastDot)), m_Context.Symbols.Intern(full.substr(lastDot + 1)), Symbol::Empty, fullSymbol };
+	}
 	bool Parser::Accept(const Token*& token, TokenType type) noexcept {
 		const Token& currentToken = GetToken(m_Token);
 		if (currentToken.Type == type) {
@@ -78,6 +189,13 @@ namespace sam {
 			return true;
 		} else return false;
 	}
+	bool Parser::IsInlineModifier() const noexcept {
+		// 'inline' is not reserved, so it is a modifier only right before 'func' or 'proc'
+		const Token& token = GetToken(m_Token);
+		const TokenType nextType = GetToken(m_Token + 1).Type;
+		return token.Type == TokenType::Identifier && token.Word == "inline" &&
+			(nextType == TokenType::FuncKeyword || nextType == TokenType::ProcKeyword);
+	}
 	bool Parser::NextLine(int hasError) {
 		const Token* newLineToken = nullptr;
 		bool hasUnexceptedTokens = false;
@@ -101,7 +219,7 @@ namespace sam {
 		}
 
 		if (isFirst && m_Depth == 0) {
-			if (!m_Result.HasFunction("entrypoint")) {
+			if (!m_Result.HasFunction(Symbol::Entrypoint)) {
 				MESSAGEBASE << "Error: There is no 'entrypoint' procedure.\n";
 				hasError = true;
 			}
@@ -122,24 +240,240 @@ namespace sam {
 	bool Parser::FourthPass() {
 		return Pass(&Parser::ParseInstructions, false);
 	}
+	bool Parser::SinglePass() {
+		m_FieldLines.clear();
+		return Pass(&Parser::ParseLine, true);
+	}
+	bool Parser::ResolveFields() {
+		bool hasError = false;
+		for (const auto& [structure, token] : m_FieldLines) {
+			m_CurrentStructure = &m_Result.Structures[structure];
+			m_Token = token;
+			m_EmptyToken.Line = m_Tokens[token].Line;
+			hasError |= NextLine(ParseField());
+		}
+		return !hasError;
+	}
 	void Parser::GenerateBuilders() {
 		for (auto& func : m_Result.Functions) {
-			if (func.Name == "entrypoint") {
-				func.Builder = std::make_unique<sgn::Builder>(m_Result.ByteFile, m_Result.ByteFile.GetEntrypoint());
+			GenerateBuilder(func);
+		}
+	}
+	void Parser::GenerateBuilder(Function& func) {
+		if (func.Name == Symbol::Entrypoint) {
+			func.Builder = std::make_unique<sgn::Builder>(m_Result.ByteFile, m_Result.ByteFile.GetEntrypoint());
+		} else {
+			func.Builder = std::make_unique<sgn::Builder>(m_Result.ByteFile, func.Index);
+		}
+
+		for (auto& label : func.Labels) {
+			label.Index = func.Builder->ReserveLabel(std::string(GetString(label.Name)));
+		}
+
+		std::uint32_t i = 0;
+		for (auto& param : func.LocalVariables) {
+			param.Index = func.Builder->GetArgument(i++);
+		}
+	}
+
+	void Parser::RemoveUnusedSections() {
+		std::vector<Symbol> roots;
+		if (IsLinkedStatically()) {
+			// Names in this module still refer to the linked modules through namespaces
+			for (std::size_t i = 0; i < m_ModuleStructureCount; ++i) {
+				for (auto& field : m_Result.Structures[i].Fields) {
+					field.Type.ElementTypeName = GetLinkedName(m_Result, Symbol::Empty, field.Type.ElementTypeName, false);
+				}
+			}
+			for (std::size_t i = 0; i < m_ModuleFunctionCount; ++i) {
+				LinkNames(m_Result, Symbol::Empty, m_Result.Functions[i].Instructions);
+			}
+
+			// Without '--gc-sections', static linking drops only what it pulled in from other modules
+			if (!m_Context.UseGcSections) {
+				for (std::size_t i = 0; i < m_ModuleStructureCount; ++i) {
+					roots.push_back(m_Result.Structures[i].Name);
+				}
+				for (std::size_t i = 0; i < m_ModuleFunctionCount; ++i) {
+					roots.push_back(m_Result.Functions[i].Name);
+				}
+			}
+		}
+
+		const auto [functionCount, structureCount] = EliminateUnusedSections(m_Result, roots);
+		if (functionCount == 0 && structureCount == 0) return;
+
+		m_Context.Statistics.AddRemovedSections(functionCount, structureCount);
+		LayOutSections();
+	}
+	void Parser::SortFunctionsByProfile() {
+		// Hot functions first, so that they are close together in the byte file. Functions not in the profile never ran.
+		std::vector<std::pair<std::uint64_t, std::size_t>> counts; // (Execution count, Function)
+		for (std::size_t i = 0; i < m_Result.Functions.size(); ++i) {
+			const std::string_view name = GetString(m_Result.Functions[i].Name);
+			counts.emplace_back(m_Context.Profile->GetFunctionCount(name).value_or(0), i);
+		}
+		std::stable_sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+			return a.first > b.first;
+		});
+
+		bool isSorted = true;
+		for (std::size_t i = 0; i < counts.size(); ++i) {
+			isSorted &= counts[i].second == i;
+		}
+		if (isSorted) return;
+
+		std::vector<Function> functions = std::move(m_Result.Functions);
+		m_Result.Functions.clear();
+		m_Result.FunctionNames = NameIndex();
+		for (const auto& [count, i] : counts) {
+			m_Result.AddFunction(std::move(functions[i]));
+		}
+		LayOutSections();
+	}
+	void Parser::LayOutSections() {
+		// ByteFile cannot drop or move what was already added to it, so lay out all sections again
+		for (auto& function : m_Result.Functions) {
+			function.Builder.reset();
+		}
+		m_Result.ByteFile = sgn::ByteFile();
+
+		std::vector<ExternModule*> externModules = m_ExternModules;
+		if (!IsLinkedStatically()) {
+			for (auto& dependency : m_Result.Dependencies) {
+				externModules.push_back(&dependency);
+			}
+		}
+		for (const auto module : externModules) {
+			for (auto& structure : module->Assembly.Structures) {
+				structure.MappedIndex.reset();
+			}
+			DeclareExternModule(*module);
+		}
+
+		for (auto& structure : m_Result.Structures) {
+			structure.Index = m_Result.ByteFile.AddStructure(std::string(GetString(structure.Name)));
+		}
+		for (auto& structure : m_Result.Structures) {
+			GenerateFields(structure);
+		}
+
+		for (auto& function : m_Result.Functions) {
+			if (function.Name == Symbol::Entrypoint) continue;
+
+			function.Index = m_Result.ByteFile.AddFunction(std::string(GetString(function.Name)), function.Arity, function.HasResult);
+		}
+		GenerateBuilders();
+	}
+
+	void Parser::GenerateFields(Structure& structure) {
+		for (auto& field : structure.Fields) {
+			const sgn::Type elementType = GetType(field.Type.ElementTypeName);
+			field.Index = m_Result.ByteFile.GetStructureInfo(structure.Index)->AddField(elementType, field.Type.ElementCount.value_or(0));
+		}
+	}
+	void Parser::LinkModules() {
+		if (!IsLinkedStatically()) return;
+
+		m_ModuleStructureCount = m_Result.Structures.size();
+		m_ModuleFunctionCount = m_Result.Functions.size();
+		for (auto& dependency : m_Result.Dependencies) {
+			if (IsNativeModule(dependency)) {
+				AddExternModule(dependency);
 			} else {
-				func.Builder = std::make_unique<sgn::Builder>(m_Result.ByteFile, func.Index);
+				LinkModule(dependency);
 			}
+		}
+		for (std::size_t i = m_ModuleStructureCount; i < m_Result.Structures.size(); ++i) {
+			GenerateFields(m_Result.Structures[i]);
+		}
+	}
+	void Parser::LinkModule(ExternModule& module) {
+		if (!m_LinkedModules.insert(module.Path).second) return;
 
-			for (auto& label : func.Labels) {
-				label.Index = func.Builder->ReserveLabel(label.Name);
+		for (auto& dependency : module.Assembly.Dependencies) {
+			if (IsNativeModule(dependency)) {
+				AddExternModule(dependency);
+			} else {
+				LinkModule(dependency);
 			}
+		}
+
+		for (const auto& structure : module.Assembly.Structures) {
+			const Symbol name = m_Context.Symbols.Concat(module.Path, structure.Name);
+			const sgn::StructureIndex index = m_Result.ByteFile.AddStructure(std::string(GetString(name)));
 
-			std::uint32_t i = 0;
-			for (auto& param : func.LocalVariables) {
-				param.Index = func.Builder->GetArgument(i++);
+			Structure& linkedStructure = m_Result.AddStructure(Structure{ name, index });
+			for (const auto& field : structure.Fields) {
+				const Name typeName = GetLinkedName(module.Assembly, module.Path, field.Type.ElementTypeName, false);
+				linkedStructure.AddField(Field{ field.Name, field.Index, Type{ typeName, field.Type.ElementCount } });
+			}
+		}
+
+		for (const auto& function : module.Assembly.Functions) {
+			if (function.Name == Symbol::Entrypoint) continue;
+
+			const Symbol name = m_Context.Symbols.Concat(module.Path, function.Name);
+			const sgn::FunctionIndex index = m_Result.ByteFile.AddFunction(std::string(GetString(name)), function.Arity, function.HasResult);
+
+			Function& linkedFunction = m_Result.AddFunction(Function{ nullptr, name, index, function.Arity, function.HasResult, function.IsInline });
+			for (const auto& label : function.Labels) {
+				linkedFunction.AddLabel(Label{ label.Name });
+			}
+			for (const auto& param : function.LocalVariables) {
+				linkedFunction.AddLocalVariable(LocalVariable{ param.Name });
+			}
+
+			linkedFunction.Instructions = function.Instructions;
+			LinkNames(module.Assembly, module.Path, linkedFunction.Instructions);
+
+			GenerateBuilder(linkedFunction);
+			m_LinkedFunctions.emplace(name, &module);
+		}
+	}
+	void Parser::LinkNames(Assembly& assembly, Symbol modulePath, std::vector<Instruction>& instructions) {
+		for (auto& instruction : instructions) {
+			if (std::holds_alternative<Type>(instruction.Operand)) {
+				Name& typeName = std::get<Type>(instruction.Operand).ElementTypeName;
+				typeName = GetLinkedName(assembly, modulePath, typeName, false);
+			} else if (std::holds_alternative<Name>(instruction.Operand)) {
+				Name& operandName = std::get<Name>(instruction.Operand);
+				operandName = GetLinkedName(assembly, modulePath, operandName, instruction.Mnemonic == Mnemonic::Call);
 			}
 		}
 	}
+	Name Parser::GetLinkedName(Assembly& assembly, Symbol modulePath, const Name& name, bool isFunction) {
+		// modulePath is empty for this module, whose sections keep their names
+		if (name.NameSpace != Symbol::Empty) {
+			const auto dependency = assembly.FindDependencyByNameSpace(name.NameSpace);
+			if (dependency != assembly.Dependencies.end() && IsNativeModule(*dependency)) {
+				return Name{ dependency->Path, name.Identifier, name.Member, name.Full }; // Resolved by GetDependency
+			} else if (dependency != assembly.Dependencies.end()) {
+				return Name{ Symbol::Empty, m_Context.Symbols.Concat(dependency->Path, name.Identifier), name.Member, name.Full };
+			} else if (modulePath == Symbol::Empty) return name; // Reported when lowering
+			else return Name{ Symbol::Empty, m_Context.Symbols.Concat(m_Context.Symbols.Concat(modulePath, name.NameSpace), name.Identifier),
+				name.Member, name.Full }; // Nonexistent, reported when lowering
+		} else if (modulePath == Symbol::Empty) return name;
+		else if (!isFunction && !assembly.HasStructure(name.Identifier) && GetFundamentalTypes().count(GetString(name.Identifier))) return name;
+
+		return Name{ Symbol::Empty, m_Context.Symbols.Concat(modulePath, name.Identifier), name.Member, name.Full };
+	}
+	void Parser::AddExternModule(ExternModule& module) {
+		if (FindExternModule(module.Path)) return;
+
+		DeclareExternModule(module);
+		m_ExternModules.push_back(&module);
+	}
+	ExternModule* Parser::FindExternModule(Symbol path) noexcept {
+		const auto iter = std::find_if(m_ExternModules.begin(), m_ExternModules.end(), [path](const ExternModule* module) {
+			return module->Path == path;
+		});
+		return iter != m_ExternModules.end() ? *iter : nullptr;
+	}
+	bool Parser::IsNativeModule(const ExternModule& module) const noexcept {
+		// Standard modules only declare what the virtual machine provides, so they have nothing to link
+		return GetString(module.Path).substr(0, 5) == "/std/";
+	}
 
 	bool Parser::IgnoreImport() {
 		const Token* token = nullptr;
@@ -151,7 +485,7 @@ namespace sam {
 		return false;
 	}
 	bool Parser::IgnoreStructure() {
-		m_CurrentStructure = &m_Result.GetStructure(GetToken(m_Token).Word);
+		m_CurrentStructure = &m_Result.GetStructure(std::get<Symbol>(GetToken(m_Token).Data));
 		m_CurrentFunction = nullptr;
 
 		m_Token += 2;
@@ -159,7 +493,7 @@ namespace sam {
 	}
 	bool Parser::IgnoreFunction() {
 		m_CurrentStructure = nullptr;
-		m_CurrentFunction = &m_Result.GetFunction(GetToken(m_Token).Word);
+		m_CurrentFunction = &m_Result.GetFunction(std::get<Symbol>(GetToken(m_Token).Data));
 
 		const Token* token = nullptr;
 		while (!Accept(token, TokenType::Colon)) {
@@ -173,11 +507,34 @@ namespace sam {
 		return false;
 	}
 
+	int Parser::ParseLine() {
+		const Token* token = nullptr;
+		if (Accept(token, TokenType::ImportKeyword)) return IsPrototypeOnly() ? IgnoreImport() : ParseImport();
+		else if (Accept(token, TokenType::StructKeyword)) return ParseStructure();
+		else if (AcceptOr(token, TokenType::FuncKeyword, TokenType::ProcKeyword)) return ParseFunction(token->Type == TokenType::FuncKeyword);
+		else if (IsInlineModifier()) return ParseInlineFunction();
+		else if (GetToken(m_Token + 1).Type == TokenType::Colon) {
+			const std::size_t nameToken = m_Token;
+			const bool hasError = ParseLabel();
+			if (!hasError && (m_Depth == 0 || m_Context.UseStaticLinking)) {
+				m_CurrentFunction->Instructions.push_back({ Mnemonic::Label, std::get<Symbol>(GetToken(nameToken).Data), nameToken });
+			}
+			return hasError;
+		} else if (m_CurrentStructure) {
+			if (IsPrototypeOnly()) return 2;
+
+			m_FieldLines.emplace_back(static_cast<std::size_t>(m_CurrentStructure - m_Result.Structures.data()), m_Token);
+			return 2;
+		} else if (m_Depth > 0 && !m_Context.UseStaticLinking) return 2;
+		else return ParseInstruction();
+	}
+
 	int Parser::ParsePrototypes() {
 		const Token* token = nullptr;
 		if (Accept(token, TokenType::ImportKeyword)) return IgnoreImport();
 		else if (Accept(token, TokenType::StructKeyword)) return ParseStructure();
 		else if (AcceptOr(token, TokenType::FuncKeyword, TokenType::ProcKeyword)) return ParseFunction(token->Type == TokenType::FuncKeyword);
+		else if (IsInlineModifier()) return ParseInlineFunction();
 		else if (GetToken(m_Token + 1).Type == TokenType::Colon) return ParseLabel();
 		else return 2;
 	}
@@ -202,19 +559,18 @@ namespace sam {
 
 		bool hasError = false;
 
-		if (m_Result.HasStructure(nameToken->Word)) {
+		const Symbol name = std::get<Symbol>(nameToken->Data);
+		if (m_Result.HasStructure(name)) {
 			ERROR << "Duplicated structure name '" << nameToken->Word << "'.\n";
 			hasError = true;
 		}
 
-		const sgn::StructureIndex index = m_Result.ByteFile.AddStructure(nameToken->Word);
-		m_Result.Structures.push_back(Structure{ nameToken->Word, index });
-
-		m_CurrentStructure = &m_Result.Structures.back();
+		const sgn::StructureIndex index = m_Result.ByteFile.AddStructure(std::string(nameToken->Word));
+		m_CurrentStructure = &m_Result.AddStructure(Structure{ name, index });
 		m_CurrentFunction = nullptr;
 		return hasError;
 	}
-	bool Parser::ParseFunction(bool hasResult) {
+	bool Parser::ParseFunction(bool hasResult, bool isInline) {
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
 			if (AcceptOr(nameToken, TokenType::None, TokenType::NewLine)) {
@@ -235,9 +591,8 @@ namespace sam {
 
 		bool hasError = false;
 
-		std::vector<LocalVariable> params;
+		std::vector<Symbol> params;
 		if (colonOrParamBeginToken->Type == TokenType::LeftParenthesis) {
-			std::vector<std::string> strParams;
 
 			const Token* token = nullptr;
 			const Token* beforeToken = nullptr;
@@ -252,7 +607,7 @@ namespace sam {
 						ERROR << "Excepted ',' after parameter name.\n";
 						hasError = true;
 					} else {
-						strParams.push_back(token->Word);
+						params.push_back(std::get<Symbol>(token->Data));
 					}
 				} else if (Accept(token, TokenType::Comma)) {
 					if (!beforeToken) {
@@ -276,15 +631,12 @@ namespace sam {
 				beforeToken = token;
 			}
 
-			std::vector<std::string> sortedStrParams = strParams;
-			std::sort(sortedStrParams.begin(), sortedStrParams.end());
-			if (const auto duplicated = std::unique(sortedStrParams.begin(), sortedStrParams.end()); duplicated != sortedStrParams.end()) {
-				ERROR << "Duplicated parameter name '" << *duplicated << "'.\n";
+			std::vector<Symbol> sortedParams = params;
+			std::sort(sortedParams.begin(), sortedParams.end());
+			if (const auto duplicated = std::adjacent_find(sortedParams.begin(), sortedParams.end()); duplicated != sortedParams.end()) {
+				ERROR << "Duplicated parameter name '" << GetString(*duplicated) << "'.\n";
 				hasError = true;
 			}
-			std::transform(strParams.begin(), strParams.end(), std::back_inserter(params), [](auto& name) -> LocalVariable {
-				return { std::move(name) };
-			});
 
 			if (token->Type == TokenType::RightParenthesis) {
 				const Token* colonToken = nullptr;
@@ -295,25 +647,32 @@ namespace sam {
 			} else return true;
 		}
 
-		if (m_Result.HasFunction(nameToken->Word)) {
+		const Symbol name = std::get<Symbol>(nameToken->Data);
+		if (m_Result.HasFunction(name)) {
 			ERROR << "Duplicated function or procedure name '" << nameToken->Word << "'.\n";
 			hasError = true;
 		}
 
 		sgn::FunctionIndex index = sgn::FunctionIndex::OperandIndex/*Dummy*/;
-		if (nameToken->Word != "entrypoint") {
-			index = m_Result.ByteFile.AddFunction(nameToken->Word, static_cast<std::uint16_t>(params.size()), hasResult);
+		if (name != Symbol::Entrypoint) {
+			index = m_Result.ByteFile.AddFunction(std::string(nameToken->Word), static_cast<std::uint16_t>(params.size()), hasResult);
 		} else if (hasResult) {
 			ERROR << "Invalid function name 'entrypoint'.\n";
 			INFO << "It can be used only for procedure.\n";
 			hasError = true;
 		}
-		m_Result.Functions.push_back(Function{ nullptr, nameToken->Word, index, {}, std::move(params) });
-
 		m_CurrentStructure = nullptr;
-		m_CurrentFunction = &m_Result.Functions.back();
+		m_CurrentFunction = &m_Result.AddFunction(Function{ nullptr, name, index, static_cast<std::uint16_t>(params.size()), hasResult, isInline });
+		for (const Symbol param : params) {
+			m_CurrentFunction->AddLocalVariable(LocalVariable{ param });
+		}
 		return hasError;
 	}
+	bool Parser::ParseInlineFunction() {
+		const bool hasResult = GetToken(m_Token + 1).Type == TokenType::FuncKeyword;
+		m_Token += 2;
+		return ParseFunction(hasResult, true);
+	}
 	bool Parser::ParseLabel() {
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
@@ -326,12 +685,13 @@ namespace sam {
 
 		bool hasError = false;
 
-		if (m_CurrentFunction->HasLabel(nameToken->Word)) {
+		const Symbol name = std::get<Symbol>(nameToken->Data);
+		if (m_CurrentFunction->HasLabel(name)) {
 			ERROR << "Duplicated label name '" << nameToken->Word << "'.\n";
 			hasError = true;
 		}
 
-		m_CurrentFunction->Labels.push_back(Label{ nameToken->Word });
+		m_CurrentFunction->AddLabel(Label{ name });
 		++m_Token;
 		return hasError;
 	}
@@ -341,24 +701,23 @@ namespace sam {
 		if (Accept(token, TokenType::ImportKeyword)) return ParseImport();
 		else if (Accept(token, TokenType::StructKeyword)) return IgnoreStructure();
 		else if (AcceptOr(token, TokenType::FuncKeyword, TokenType::ProcKeyword)) return IgnoreFunction();
+		else if (IsInlineModifier()) return m_Token += 2, IgnoreFunction();
 		else if (GetToken(m_Token + 1).Type == TokenType::Colon) return IgnoreLabel();
 		else return 2;
 	}
 	std::optional<Name> Parser::ParseName(const std::string& required, int dot, bool isType, bool isField) {
 		bool hasError = false;
-		std::string name;
+		std::vector<Symbol> parts;
 
 		const Token* token = nullptr;
 		const Token* beforeToken = nullptr;
 		while (true) {
 			if (AcceptOr(token, TokenType::None, TokenType::NewLine)) {
+				--m_Token;
 				if (!beforeToken) {
 					ERROR << "Required " << required << ".\n";
 					return std::nullopt;
-				} else {
-					--m_Token;
-					break;
-				}
+				} else break;
 			} else if (Accept(token, TokenType::Identifier)) {
 				if (beforeToken && beforeToken->Type == TokenType::Identifier) {
 					if (isField) {
@@ -377,7 +736,7 @@ namespace sam {
 						hasError = true;
 					}
 				} else {
-					name.append(token->Word);
+					parts.push_back(std::get<Symbol>(token->Data));
 				}
 			} else if (Accept(token, TokenType::Dot)) {
 				if (!beforeToken) {
@@ -389,8 +748,6 @@ namespace sam {
 				} else if (beforeToken->Type == TokenType::Dot) {
 					ERROR << "Excepted " << required << " after '.'.\n";
 					hasError = true;
-				} else {
-					name.push_back('.');
 				}
 			} else {
 				if (isType && IsTypeKeyword(GetToken(m_Token).Type)) {
@@ -403,7 +760,7 @@ namespace sam {
 						--m_Token;
 						break;
 					} else {
-						name.append(token->Word);
+						parts.push_back(std::get<Symbol>(token->Data));
 					}
 				} else if (!beforeToken) {
 					ERROR << "Required " << required << ".\n";
@@ -422,34 +779,33 @@ namespace sam {
 			return std::nullopt;
 		}
 
-		if (dot == 1) {
-			const std::size_t lastDot = name.find_last_of('.');
-			if (lastDot == std::string::npos) {
-				return Name{ "", name, name };
-			} else {
-				return Name{ name.substr(0, lastDot), name.substr(lastDot + 1), name };
+		const auto join = [this, &parts](std::size_t count) {
+			Symbol result = Symbol::Empty;
+			for (std::size_t i = 0; i < count; ++i) {
+				result = i == 0 ? parts[i] : m_Context.Symbols.Concat(result, parts[i]);
 			}
+			return result;
+		};
+
+		const Symbol full = join(parts.size());
+		if (dot == 1) {
+			return Name{ join(parts.size() - 1), parts.back(), Symbol::Empty, full };
 		} else if (dot == 2) {
-			const std::size_t lastDot = name.find_last_of('.');
-			if (lastDot == std::string::npos) {
+			if (parts.size() < 2) {
 				ERROR << "Excepted '.' after identifier.\n";
 				return std::nullopt;
 			}
 
-			const std::size_t prevLastDot = name.find_last_of('.', lastDot - 1);
-			if (prevLastDot == std::string::npos) {
-				return Name{ "", name, name };
-			} else {
-				return Name{ name.substr(0, prevLastDot), name.substr(prevLastDot + 1), name };
-			}
+			return Name{ join(parts.size() - 2), parts[parts.size() - 2], parts.back(), full };
 		} else {
-			return Name{ name, "", name };
+			return Name{ full, Symbol::Empty, Symbol::Empty, full };
 		}
 	}
 	bool Parser::ParseExternModule(const Name& namespaceName, const std::string& path) {
 		const std::string resolvedPath = std::filesystem::weakly_canonical(path).generic_string();
+		const Symbol resolvedPathSymbol = m_Context.Symbols.Intern(resolvedPath);
 		std::string realPath = resolvedPath;
-		if (m_Result.HasDependency(resolvedPath)) {
+		if (m_Result.HasDependency(resolvedPathSymbol)) {
 			ERROR << "Already imported module '" << path << "'.\n";
 			return true;
 		} else if (path.find("std/") == 0) {
@@ -458,7 +814,7 @@ namespace sam {
 			if (resolvedPath.find("std/") == 1) {
 				realPath.erase(realPath.begin());
 			} else {
-				for (const char* directory : m_ImportDirectories) {
+				for (const char* directory : m_Context.ImportDirectories) {
 					const auto tempPath = std::filesystem::path(directory) / resolvedPath.substr(1);
 					if (std::filesystem::exists(tempPath)) {
 						realPath = std::filesystem::weakly_canonical(tempPath).generic_string();
@@ -472,69 +828,206 @@ namespace sam {
 		}
 
 	parse:
-		std::ifstream inputStream(realPath);
-		if (!inputStream) {
-			ERROR << "Failed to open '" << path << "'.\n";
-			return true;
+		ImportJob job{ m_Result.Dependencies.size(), m_Token, m_EmptyToken.Line, path, std::move(realPath) };
+		m_Result.AddDependency(ExternModule{ resolvedPathSymbol, {}, {}, namespaceName.Full, path });
+
+		if (m_Context.ThreadPool) {
+			m_Imports.push_back(std::move(job));
+			return false;
+		} else {
+			LoadExternModule(job);
+			return LinkExternModule(job);
+		}
+	}
+	void Parser::LoadExternModule(ImportJob& job) const {
+		const std::string modulePath = std::filesystem::absolute(job.RealPath).lexically_normal().generic_string();
+		const bool isCircular = std::find(m_ImportChain.begin(), m_ImportChain.end(), modulePath) != m_ImportChain.end();
+		if (m_Context.UseStaticLinking && isCircular) {
+			job.IsOpened = true;
+			job.IsCircular = true;
+			return;
+		}
+
+		// Another thread may already be parsing the same file for a sibling import, in which case its result is reused.
+		// Interfaces have no function bodies, so static linking always parses the source.
+		const bool isLoading = !m_Context.UseStaticLinking && !isCircular && m_Context.Modules.BeginLoad(modulePath, m_ImportChain);
+		if (const auto registered = m_Context.UseStaticLinking ? std::nullopt : m_Context.Modules.Find(modulePath);
+			registered && (registered->IsComplete || m_Depth > 0)) {
+			job.Module = CreateModule(job, modulePath, nullptr, {});
+			if (job.Module->Load(*registered) && !job.Module->HasMessage()) {
+				m_Context.Statistics.AddReusedModule();
+				job.ContentHash = registered->ContentHash;
+				job.IsOpened = true;
+				return;
+			}
 		}
 
-		ExternModule& module = m_Result.Dependencies.emplace_back(ExternModule{ resolvedPath });
+		ReadExternModule(job, modulePath);
+		if (isLoading) {
+			m_Context.Modules.EndLoad(modulePath);
+		}
+	}
+	void Parser::ReadExternModule(ImportJob& job, const std::string& modulePath) const {
+		// An entry whose source has the same write time and size is used without reading the source.
+		if (m_Context.ModuleCache && !m_Context.UseStaticLinking) {
+			auto interface = m_Context.ModuleCache->Load(modulePath);
+			if (interface && (interface->IsComplete || m_Depth > 0)) {
+				job.Module = CreateModule(job, modulePath, nullptr, {});
+				if (job.Module->Load(*interface) && !job.Module->HasMessage()) {
+					m_Context.Statistics.AddCachedModule();
+					job.ContentHash = interface->ContentHash;
+					job.IsOpened = true;
+					m_Context.Modules.Register(modulePath, std::move(*interface));
+					return;
+				}
+			}
+		}
 
-		Lexer lexer(path, inputStream);
+		const auto readBegin = std::chrono::steady_clock::now();
+		const auto source = std::make_shared<Source>();
+		if (!source->Open(job.RealPath)) {
+			job.Module.reset();
+			return;
+		}
+		job.IsOpened = true;
+		job.ContentHash = ModuleCache::Hash(source->GetData());
+
+		if (m_Context.ModuleCache && !m_Context.UseStaticLinking) {
+			auto interface = m_Context.ModuleCache->Load(modulePath, job.ContentHash);
+			if (interface && (interface->IsComplete || m_Depth > 0)) {
+				job.Module = CreateModule(job, modulePath, source, {});
+				if (job.Module->Load(*interface) && !job.Module->HasMessage()) {
+					m_Context.Statistics.AddInput(*source, std::chrono::steady_clock::now() - readBegin, {});
+					m_Context.Statistics.AddCachedModule();
+					m_Context.ModuleCache->Store(modulePath, job.ContentHash, *interface); // Only touched, so the write time is refreshed
+					m_Context.Modules.Register(modulePath, std::move(*interface));
+					return;
+				}
+			}
+		}
+
+		const auto lexBegin = std::chrono::steady_clock::now();
+		Lexer lexer(job.Path, source, m_Context.Symbols);
 		lexer.Lex();
+		m_Context.Statistics.AddInput(*source, lexBegin - readBegin, std::chrono::steady_clock::now() - lexBegin);
 		if (lexer.HasMessage()) {
-			m_ErrorStream << lexer.GetMessages();
+			job.Messages = lexer.GetMessages();
 			if (lexer.HasError()) {
-				m_HasError = true;
-				return true;
+				job.Module.reset();
+				return;
 			}
 		}
 
-		Parser parser(m_ImportDirectories, path, lexer.GetTokens(), m_Depth + 1);
-		parser.Parse();
-		if (parser.HasMessage()) {
-			m_ErrorStream << parser.GetMessages();
-			if (parser.HasError()) {
+		job.Module = CreateModule(job, modulePath, lexer.GetSource(), lexer.GetTokens());
+		job.Module->Parse();
+		if (!job.Module->HasMessage() && !m_Context.UseStaticLinking) {
+			ModuleInterface interface = job.Module->GetInterface();
+			interface.ContentHash = job.ContentHash;
+			if (m_Context.ModuleCache) {
+				m_Context.ModuleCache->Store(modulePath, job.ContentHash, interface);
+			}
+			m_Context.Modules.Register(modulePath, std::move(interface));
+		}
+	}
+	// Modules loaded from an interface also import, so they need the chain as well to detect cycles.
+	std::unique_ptr<Parser> Parser::CreateModule(const ImportJob& job, const std::string& modulePath,
+		std::shared_ptr<const Source> source, std::vector<Token> tokens) const {
+		auto module = std::make_unique<Parser>(m_Context, job.Path, std::move(source), std::move(tokens), m_Depth + 1);
+		module->m_ImportChain = m_ImportChain;
+		module->m_ImportChain.push_back(modulePath);
+		return module;
+	}
+	bool Parser::LinkExternModule(ImportJob& job) {
+		if (job.IsCircular) {
+			ERROR << "Circular import of '" << job.Path << "' cannot be linked statically.\n";
+			return true;
+		} else if (!job.Module && !job.IsOpened) {
+			ERROR << "Failed to open '" << job.Path << "'.\n";
+			return true;
+		}
+
+		m_ErrorStream << job.Messages;
+		if (!job.Module) {
+			m_HasError = true;
+			return true;
+		}
+
+		const std::unique_ptr<Parser> parser = std::move(job.Module);
+		if (parser->HasMessage()) {
+			m_ErrorStream << parser->GetMessages();
+			if (parser->HasError()) {
 				m_HasError = true;
 				return true;
 			}
 		}
 
-		if (m_Depth <= 1) {
-			module.Assembly = parser.GetAssembly();
-			module.NameSpace = namespaceName.Full;
-			if (resolvedPath[0] == '/') {
-				module.Index = m_Result.ByteFile.AddExternModule(
-					std::filesystem::path(resolvedPath).replace_extension("sbf").generic_string());
-			} else {
-				module.Index = m_Result.ByteFile.AddExternModule(
-					std::filesystem::relative(resolvedPath).replace_extension("sbf").generic_string());
+		ExternModule& module = m_Result.Dependencies[job.Dependency];
+		module.SourcePath = std::move(job.RealPath);
+		module.ContentHash = job.ContentHash;
+
+		if (m_Context.UseStaticLinking) {
+			module.Assembly = parser->GetAssembly();
+			module.Source = std::move(parser->m_Source);
+			module.Tokens = std::move(parser->m_Tokens);
+			if (!IsLinkedStatically()) {
+				DeclareExternModule(module);
 			}
+		} else if (m_Depth <= 1) {
+			module.Assembly = parser->GetAssembly();
+			DeclareExternModule(module);
+		}
 
-			const auto moduleInfo = m_Result.ByteFile.GetExternModuleInfo(module.Index);
+		return false;
+	}
+	void Parser::DeclareExternModule(ExternModule& module) {
+		const std::string_view resolvedPath = GetString(module.Path);
+		if (resolvedPath[0] == '/') {
+			module.Index = m_Result.ByteFile.AddExternModule(
+				std::filesystem::path(resolvedPath).replace_extension("sbf").generic_string());
+		} else {
+			module.Index = m_Result.ByteFile.AddExternModule(
+				std::filesystem::relative(resolvedPath).replace_extension("sbf").generic_string());
+		}
 
-			for (auto& structure : module.Assembly.Structures) {
-				const auto structureInfo = module.Assembly.ByteFile.GetStructureInfo(structure.Index);
+		const auto moduleInfo = m_Result.ByteFile.GetExternModuleInfo(module.Index);
 
-				std::vector<sgn::Field> fields;
-				for (auto& field : structureInfo->Fields) {
-					fields.push_back({ field.Type, field.Count });
-				}
+		for (auto& structure : module.Assembly.Structures) {
+			const auto structureInfo = module.Assembly.ByteFile.GetStructureInfo(structure.Index);
 
-				structure.ExternIndex = moduleInfo->AddStructure(structureInfo->Name, fields);
+			std::vector<sgn::Field> fields;
+			for (auto& field : structureInfo->Fields) {
+				fields.push_back({ field.Type, field.Count });
 			}
 
-			for (auto& function : module.Assembly.Functions) {
-				if (function.Name == "entrypoint") continue;
+			structure.ExternIndex = moduleInfo->AddStructure(structureInfo->Name, fields);
+		}
 
-				const auto functionInfo = module.Assembly.ByteFile.GetFunctionInfo(function.Index);
+		for (auto& function : module.Assembly.Functions) {
+			if (function.Name == Symbol::Entrypoint) continue;
 
-				function.ExternIndex = moduleInfo->AddFunction(functionInfo->Name, functionInfo->Arity, functionInfo->HasResult);
-			}
+			const auto functionInfo = module.Assembly.ByteFile.GetFunctionInfo(function.Index);
+
+			function.ExternIndex = moduleInfo->AddFunction(functionInfo->Name, functionInfo->Arity, functionInfo->HasResult);
 		}
+	}
+	bool Parser::ResolveImports() {
+		if (m_Imports.empty()) return true;
 
-		return false;
+		m_Context.ThreadPool->ParallelFor(m_Imports.size(), [this](std::size_t i) {
+			LoadExternModule(m_Imports[i]);
+		});
+
+		bool hasError = false;
+		for (auto& job : m_Imports) {
+			m_Token = job.Token;
+			m_EmptyToken.Line = job.Line;
+			hasError |= LinkExternModule(job);
+		}
+
+		m_Imports.clear();
+		return !hasError;
 	}
+
 	bool Parser::ParseImport() {
 		const Token* pathToken = nullptr;
 		if (!Accept(pathToken, TokenType::String)) {
@@ -557,15 +1050,12 @@ namespace sam {
 		auto namespaceName = ParseName("namespace name", 0, false);
 		if (!namespaceName) return true;
 
-		const auto iter = std::find_if(m_Result.Dependencies.begin(), m_Result.Dependencies.end(), [&namespaceName](const auto& module) {
-			return namespaceName->Full == module.NameSpace;
-		});
-		if (iter != m_Result.Dependencies.end()) {
-			ERROR << "Duplicated namespace name '" << namespaceName->Full << "'.\n";
+		if (m_Result.FindDependencyByNameSpace(namespaceName->Full) != m_Result.Dependencies.end()) {
+			ERROR << "Duplicated namespace name '" << GetString(namespaceName->Full) << "'.\n";
 			return true;
 		}
 
-		return ParseExternModule(*namespaceName, std::get<std::string>(pathToken->Data));
+		return ParseExternModule(*namespaceName, std::string(std::get<std::string_view>(pathToken->Data)));
 	}
 
 	int Parser::ParseFields() {
@@ -573,6 +1063,7 @@ namespace sam {
 		if (Accept(token, TokenType::ImportKeyword)) return IgnoreImport();
 		else if (Accept(token, TokenType::StructKeyword)) return IgnoreStructure();
 		else if (AcceptOr(token, TokenType::FuncKeyword, TokenType::ProcKeyword)) return IgnoreFunction();
+		else if (IsInlineModifier()) return m_Token += 2, IgnoreFunction();
 		else if (GetToken(m_Token + 1).Type == TokenType::Colon) return IgnoreLabel();
 		else if (m_CurrentStructure) return ParseField();
 		else return 2;
@@ -586,17 +1077,17 @@ namespace sam {
 		if (IsInteger(GetToken(m_Token).Type)) {
 			literalToken = &GetToken(m_Token++);
 			const std::uint64_t value = std::get<std::uint64_t>(literalToken->Data);
-			if (literalToken->Suffix == "i") {
+			if (literalToken->GetSuffix() == "i") {
 				if (value > std::numeric_limits<std::uint32_t>::max()) {
 					WARNING << "Overflowed integer literal.\n";
 				}
 				return MakeNegative(static_cast<std::uint32_t>(value), maybeMinusToken);
-			} else if (literalToken->Suffix == "l") return MakeNegative(value, maybeMinusToken);
+			} else if (literalToken->GetSuffix() == "l") return MakeNegative(value, maybeMinusToken);
 			else if (value <= std::numeric_limits<std::uint32_t>::max()) return MakeNegative(static_cast<std::uint32_t>(value), maybeMinusToken);
 			else return MakeNegative(value, maybeMinusToken);
 		} else if (Accept(literalToken, TokenType::Decimal)) {
 			const double value = std::get<double>(literalToken->Data);
-			if (literalToken->Suffix == "s") return MakeNegative(static_cast<float>(value), maybeMinusToken);
+			if (literalToken->GetSuffix() == "s") return MakeNegative(static_cast<float>(value), maybeMinusToken);
 			else return MakeNegative(value, maybeMinusToken);
 		} else return std::monostate();
 	}
@@ -627,70 +1118,40 @@ namespace sam {
 		else if (std::holds_alternative<double>(value)) return std::get<double>(value) < 0;
 		else return std::holds_alternative<std::int32_t>(value) || std::holds_alternative<std::int64_t>(value);
 	}
-	sgn::Type Parser::GetType(const Name& name, const Structure** outStructure) {
-		static const std::unordered_map<std::string, sgn::Type> fundamental = {
-			{ "int", sgn::IntType },
-			{ "long", sgn::LongType },
-			{ "single", sgn::SingleType },
-			{ "double", sgn::DoubleType },
-			{ "pointer", sgn::PointerType },
-			{ "gcpointer", sgn::GCPointerType },
-		};
-
-		auto assembly = &m_Result;
-		ExternModule* externModule = nullptr;
-
-		if (!name.NameSpace.empty()) {
-			const auto dependency = m_Result.FindDependencyByNameSpace(name.NameSpace);
-			if (dependency == m_Result.Dependencies.end()) {
-				ERROR << "Nonexistent namespace '" << name.NameSpace << "'.\n";
-				return nullptr;
+	sgn::Type Parser::GetType(const Name& name) {
+		LoweringState state;
+		state.Path = &m_Path;
+		state.Tokens = &m_Tokens;
+		state.Token = m_Token;
+
+		const auto type = GetType(state, name);
+		m_ErrorStream << state.Messages.str();
+		m_HasError |= state.HasError;
+		m_HasWarning |= state.HasWarning;
+		if (!type) return nullptr;
+		else if (!type->Structure) return type->Type;
+
+		if (type->Module) {
+			if (!type->Structure->MappedIndex) {
+				type->Structure->MappedIndex = m_Result.ByteFile.Map(type->Module->Index, *type->Structure->ExternIndex);
 			}
-
-			externModule = &*dependency;
-			assembly = &dependency->Assembly;
-		}
-
-		const auto iter = fundamental.find(name.Identifier);
-		if (iter != fundamental.end()) {
-			if (externModule) {
-				WARNING << "Use just '" << name.Identifier << "' instead of '" << name.Full << "'.\n";
-			}
-			return svm::GetFundamentalType(iter->second->Code);
-		}
-
-		const auto structure = assembly->FindStructure(name.Identifier);
-		if (structure == assembly->Structures.end()) {
-			ERROR << "Nonexistent structure '" << name.Identifier << "'.\n";
-			return nullptr;
-		} else if (structure->ExternIndex && !structure->MappedIndex) {
-			structure->MappedIndex = m_Result.ByteFile.Map(externModule->Index, *structure->ExternIndex);
-		}
-
-		if (outStructure) {
-			*outStructure = &*structure;
-		}
-
-		if (externModule) {
-			return m_Result.ByteFile.GetStructureInfo(*structure->MappedIndex)->Type;
+			return m_Result.ByteFile.GetStructureInfo(*type->Structure->MappedIndex)->Type;
 		} else {
-			return m_Result.ByteFile.GetStructureInfo(structure->Index)->Type;
+			return m_Result.ByteFile.GetStructureInfo(type->Structure->Index)->Type;
 		}
 	}
 	std::optional<Type> Parser::ParseType(bool isField) {
 		const auto typeName = ParseName("type name", 1, true, isField);
 		if (!typeName) return std::nullopt;
-	
-		const auto type = GetType(*typeName);
 
 		const Token* maybeLeftBracketToken = nullptr;
-		if (!Accept(maybeLeftBracketToken, TokenType::LeftBracket)) return Type{ type, typeName->Full };
+		if (!Accept(maybeLeftBracketToken, TokenType::LeftBracket)) return Type{ *typeName };
 
 		bool hasError = false;
 		std::uint64_t length = 0;
 
 		const Token* lengthOrRightBracketToken = nullptr;
-		if (Accept(lengthOrRightBracketToken, TokenType::RightBracket)) return Type{ type, typeName->Full, 0 };
+		if (Accept(lengthOrRightBracketToken, TokenType::RightBracket)) return Type{ *typeName, 0 };
 		else if (Accept(lengthOrRightBracketToken, TokenType::Decimal)) {
 			ERROR << "Array's length must be integer.\n";
 			hasError = true;
@@ -708,7 +1169,7 @@ namespace sam {
 					length = std::get<std::uint64_t>(lengthTemp);
 				}
 
-				if ((length = std::get<std::uint64_t>(GetToken(m_Token++).Data)) == 0) {
+				if (length == 0) {
 					ERROR << "Array's length cannot be zero.\n";
 					hasError = true;
 				}
@@ -722,15 +1183,17 @@ namespace sam {
 		if (!Accept(rightBracketToken, TokenType::RightBracket)) {
 			ERROR << "Excepted ']' after array's length.\n";
 			return std::nullopt;
-		} else return Type{ type, typeName->Full, length };
+		} else return Type{ *typeName, length };
 	}
 	bool Parser::ParseField() {
 		bool hasError = false;
 
 		const auto type = ParseType(true);
 		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
+
+		const sgn::Type elementType = GetType(type->ElementTypeName);
+		if (elementType == nullptr) {
+			ERROR << "Nonexistent type '" << GetString(type->ElementTypeName.Full) << "'.\n";
 			return true;
 		} else if (type->ElementCount && *type->ElementCount == 0) {
 			ERROR << "Required array's length.\n";
@@ -750,13 +1213,14 @@ namespace sam {
 		const sgn::StructureIndex structIndex = m_CurrentStructure->Index;
 		sgn::StructureInfo* const structureInfo = m_Result.ByteFile.GetStructureInfo(structIndex);
 
-		if (m_CurrentStructure->HasField(nameToken->Word)) {
+		const Symbol name = std::get<Symbol>(nameToken->Data);
+		if (m_CurrentStructure->HasField(name)) {
 			ERROR << "Duplicated field name '" << nameToken->Word << "'.\n";
 			hasError = true;
 		}
 
-		const sgn::FieldIndex index = structureInfo->AddField(type->ElementType, type->ElementCount.value_or(0));
-		m_CurrentStructure->Fields.push_back(Field{ nameToken->Word, index });
+		const sgn::FieldIndex index = structureInfo->AddField(elementType, type->ElementCount.value_or(0));
+		m_CurrentStructure->AddField(Field{ name, index, *type });
 		return hasError;
 	}
 
@@ -765,13 +1229,15 @@ namespace sam {
 		if (Accept(token, TokenType::ImportKeyword)) return IgnoreImport();
 		else if (Accept(token, TokenType::StructKeyword)) return IgnoreStructure();
 		else if (AcceptOr(token, TokenType::FuncKeyword, TokenType::ProcKeyword)) return IgnoreFunction();
+		else if (IsInlineModifier()) return m_Token += 2, IgnoreFunction();
 		else if (GetToken(m_Token + 1).Type == TokenType::Colon) {
-			m_CurrentFunction->Builder->AddLabel(GetToken(m_Token).Word);
+			m_CurrentFunction->Instructions.push_back({ Mnemonic::Label, std::get<Symbol>(GetToken(m_Token).Data), m_Token });
 			return IgnoreLabel();
 		} else if (m_CurrentStructure) return 2;
 		else return ParseInstruction();
 	}
 	bool Parser::ParseInstruction() {
+		const std::size_t token = m_Token;
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
 			if (AcceptOr(nameToken, TokenType::None, TokenType::NewLine)) return false;
@@ -784,517 +1250,757 @@ namespace sam {
 			return true;
 		}
 
-		std::string mnemonic = nameToken->Word;
-		std::transform(mnemonic.begin(), mnemonic.end(), mnemonic.begin(), [](char c) {
-			return static_cast<char>(std::tolower(c));
-		});
-
-		switch (CRC32(mnemonic)) {
-		case "nop"_h: m_CurrentFunction->Builder->Nop(); break;
-
-		case "push"_h: return ParsePushInstruction();
-		case "pop"_h: m_CurrentFunction->Builder->Pop(); break;
-		case "load"_h: return ParseLoadInstruction();
-		case "store"_h: return ParseStoreInstruction();
-		case "lea"_h: return ParseLeaInstruction();
-		case "flea"_h: return ParseFLeaInstruction();
-		case "tload"_h: m_CurrentFunction->Builder->TLoad(); break;
-		case "tstore"_h: m_CurrentFunction->Builder->TStore(); break;
-		case "copy"_h: m_CurrentFunction->Builder->Copy(); break;
-		case "swap"_h: m_CurrentFunction->Builder->Swap(); break;
-
-		case "add"_h: m_CurrentFunction->Builder->Add(); break;
-		case "sub"_h: m_CurrentFunction->Builder->Sub(); break;
-		case "mul"_h: m_CurrentFunction->Builder->Mul(); break;
-		case "imul"_h: m_CurrentFunction->Builder->IMul(); break;
-		case "div"_h: m_CurrentFunction->Builder->Div(); break;
-		case "idiv"_h: m_CurrentFunction->Builder->IDiv(); break;
-		case "mod"_h: m_CurrentFunction->Builder->Mod(); break;
-		case "imod"_h: m_CurrentFunction->Builder->IMod(); break;
-		case "neg"_h: m_CurrentFunction->Builder->Neg(); break;
-		case "inc"_h: m_CurrentFunction->Builder->Inc(); break;
-		case "dec"_h: m_CurrentFunction->Builder->Dec(); break;
-
-		case "and"_h: m_CurrentFunction->Builder->And(); break;
-		case "or"_h: m_CurrentFunction->Builder->Or(); break;
-		case "xor"_h: m_CurrentFunction->Builder->Xor(); break;
-		case "not"_h: m_CurrentFunction->Builder->Not(); break;
-		case "shl"_h: m_CurrentFunction->Builder->Shl(); break;
-		case "sal"_h: m_CurrentFunction->Builder->Sal(); break;
-		case "shr"_h: m_CurrentFunction->Builder->Shr(); break;
-		case "sar"_h: m_CurrentFunction->Builder->Sar(); break;
-
-		case "cmp"_h: m_CurrentFunction->Builder->Cmp(); break;
-		case "icmp"_h: m_CurrentFunction->Builder->ICmp(); break;
-		case "jmp"_h: return ParseJmpInstruction();
-		case "je"_h: return ParseJeInstruction();
-		case "jne"_h: return ParseJneInstruction();
-		case "ja"_h: return ParseJaInstruction();
-		case "jae"_h: return ParseJaeInstruction();
-		case "jb"_h: return ParseJbInstruction();
-		case "jbe"_h: return ParseJbeInstruction();
-		case "call"_h: return ParseCallInstruction();
-		case "ret"_h: m_CurrentFunction->Builder->Ret(); break;
-
-		case "toi"_h: m_CurrentFunction->Builder->ToI(); break;
-		case "tol"_h: m_CurrentFunction->Builder->ToL(); break;
-		case "tosi"_h: m_CurrentFunction->Builder->ToSi(); break;
-		case "tod"_h: m_CurrentFunction->Builder->ToD(); break;
-		case "top"_h: m_CurrentFunction->Builder->ToP(); break;
-
-		case "null"_h: m_CurrentFunction->Builder->Null(); break;
-		case "new"_h: return ParseNewInstruction();
-		case "delete"_h: m_CurrentFunction->Builder->Delete(); break;
-		case "gcnull"_h: m_CurrentFunction->Builder->GCNull(); break;
-		case "gcnew"_h: return ParseGCNewInstruction();
-		case "apush"_h: return ParseAPushInstruction();
-		case "anew"_h: return ParseANewInstruction();
-		case "agcnew"_h: return ParseAGCNewInstruction();
-		case "alea"_h: m_CurrentFunction->Builder->ALea(); break;
-		case "count"_h: m_CurrentFunction->Builder->Count(); break;
-
-		case "string32"_h: return ParseString32Statement();
-
-		default:
+		const Mnemonic mnemonic = FindMnemonic(nameToken->Word);
+		std::optional<Operand> operand;
+		switch (mnemonic) {
+		case Mnemonic::None:
 			ERROR << "Unknown mnemonic.\n";
 			return true;
+
+		case Mnemonic::Push: operand = ParsePushOperand(); break;
+		case Mnemonic::Load:
+		case Mnemonic::Store:
+		case Mnemonic::Lea: operand = ParseLocalVariableOperand(); break;
+		case Mnemonic::FLea: operand = ParseNameOperand("field name", 2); break;
+
+		case Mnemonic::Jmp:
+		case Mnemonic::Je:
+		case Mnemonic::Jne:
+		case Mnemonic::Ja:
+		case Mnemonic::Jae:
+		case Mnemonic::Jb:
+		case Mnemonic::Jbe: operand = ParseLabelOperand(); break;
+		case Mnemonic::Call: operand = ParseNameOperand("function or procedure name", 1); break;
+
+		case Mnemonic::New:
+		case Mnemonic::GCNew:
+		case Mnemonic::APush:
+		case Mnemonic::ANew:
+		case Mnemonic::AGCNew: operand = ParseTypeOperand(mnemonic); break;
+
+		case Mnemonic::String32: operand = ParseString32Operand(); break;
+
+		default: operand.emplace(); break;
 		}
 
+		if (!operand) return true;
+
+		m_CurrentFunction->Instructions.push_back({ mnemonic, std::move(*operand), token });
 		return false;
 	}
-	bool Parser::ParsePushInstruction() {
+	std::optional<Operand> Parser::ParsePushOperand() {
 		const auto number = ParseNumber();
-		if (!std::holds_alternative<std::monostate>(number)) {
-			if (std::holds_alternative<std::int32_t>(number)) {
-				const auto inx = m_Result.ByteFile.AddIntConstant(static_cast<std::uint32_t>(std::get<std::int32_t>(number)));
-				m_CurrentFunction->Builder->Push(inx);
-			} else if (std::holds_alternative<std::uint32_t>(number)) {
-				const auto inx = m_Result.ByteFile.AddIntConstant(std::get<std::uint32_t>(number));
-				m_CurrentFunction->Builder->Push(inx);
-			} else if (std::holds_alternative<std::int64_t>(number)) {
-				const auto inx = m_Result.ByteFile.AddLongConstant(static_cast<std::uint64_t>(std::get<std::int64_t>(number)));
-				m_CurrentFunction->Builder->Push(inx);
-			} else if (std::holds_alternative<std::uint64_t>(number)) {
-				const auto inx = m_Result.ByteFile.AddLongConstant(std::get<std::uint64_t>(number));
-				m_CurrentFunction->Builder->Push(inx);
-			} else if (std::holds_alternative<float>(number)) {
-				const auto inx = m_Result.ByteFile.AddSingleConstant(std::get<float>(number));
-				m_CurrentFunction->Builder->Push(inx);
-			} else {
-				const auto inx = m_Result.ByteFile.AddDoubleConstant(std::get<double>(number));
-				m_CurrentFunction->Builder->Push(inx);
-			}
-			return false;
-		}
-
-		const auto name = ParseName("structure name", 1, true);
-		if (!name) return true;
-
-		const Structure* structure = nullptr;
-		const sgn::Type type = GetType(*name, &structure);
-		if (structure) {
-			if (structure->MappedIndex) {
-				m_CurrentFunction->Builder->Push(*structure->MappedIndex);
-			} else {
-				m_CurrentFunction->Builder->Push(structure->Index);
-			}
-			return false;
-		} else {
-			ERROR << "Excepted literal or structure name.\n";
-			return true;
-		}
+		if (std::holds_alternative<std::int32_t>(number)) return static_cast<std::uint32_t>(std::get<std::int32_t>(number));
+		else if (std::holds_alternative<std::uint32_t>(number)) return std::get<std::uint32_t>(number);
+		else if (std::holds_alternative<std::int64_t>(number)) return static_cast<std::uint64_t>(std::get<std::int64_t>(number));
+		else if (std::holds_alternative<std::uint64_t>(number)) return std::get<std::uint64_t>(number);
+		else if (std::holds_alternative<float>(number)) return std::get<float>(number);
+		else if (std::holds_alternative<double>(number)) return std::get<double>(number);
+		else return ParseNameOperand("structure name", 1, true);
 	}
-	bool Parser::ParseLoadInstruction() {
+	std::optional<Operand> Parser::ParseLocalVariableOperand() {
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
 			ERROR << "Excepted parameter or local variable name.\n";
-			return true;
-		}
-
-		const auto var = GetLocalVaraible(nameToken->Word);
-		if (!var) {
-			ERROR << "Nonexistent local variable '" << nameToken->Word << "'.\n";
-			return true;
+			return std::nullopt;
 		}
 
-		m_CurrentFunction->Builder->Load(*var);
-		return false;
+		return std::get<Symbol>(nameToken->Data);
 	}
-	bool Parser::ParseStoreInstruction() {
+	std::optional<Operand> Parser::ParseLabelOperand() {
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted parameter or local variable name.\n";
-			return true;
+			ERROR << "Excepted label name.\n";
+			return std::nullopt;
 		}
 
-		auto var = GetLocalVaraible(nameToken->Word);
-		if (!var) {
-			var = m_CurrentFunction->Builder->AddLocalVariable();
-			m_CurrentFunction->LocalVariables.push_back(LocalVariable{ nameToken->Word, *var });
+		return std::get<Symbol>(nameToken->Data);
+	}
+	std::optional<Operand> Parser::ParseNameOperand(const std::string& required, int dot, bool isType) {
+		const auto name = ParseName(required, dot, isType);
+		if (!name) return std::nullopt;
+		else return *name;
+	}
+	std::optional<Operand> Parser::ParseTypeOperand(Mnemonic mnemonic) {
+		const auto type = ParseType();
+		if (!type) return std::nullopt;
+
+		const bool isArray = mnemonic == Mnemonic::APush || mnemonic == Mnemonic::ANew || mnemonic == Mnemonic::AGCNew;
+		if (!isArray && type->ElementCount) {
+			ERROR << "Array cannot be used here.\n";
+			INFO << "Use '" << (mnemonic == Mnemonic::New ? "anew" : "agcnew") << "' mnemonic instead.\n";
+			return std::nullopt;
+		} else if (isArray && !type->ElementCount) {
+			ERROR << "Only array can be used here.\n";
+			INFO << "Use '" << (mnemonic == Mnemonic::APush ? "push" : mnemonic == Mnemonic::ANew ? "new" : "gcnew") << "' mnemonic instead.\n";
+			return std::nullopt;
+		} else if (isArray && *type->ElementCount != 0) {
+			ERROR << "Array's length cannot be used here.\n";
+			return std::nullopt;
 		}
 
-		m_CurrentFunction->Builder->Store(*var);
-		return false;
+		return *type;
 	}
-	bool Parser::ParseLeaInstruction() {
+	std::optional<Operand> Parser::ParseString32Operand() {
+		const Token* stringToken = nullptr;
+		if (!Accept(stringToken, TokenType::String)) {
+			ERROR << "Excepted string literal.\n";
+			return std::nullopt;
+		}
+
+		const Token* toToken = nullptr;
+		if (!Accept(toToken, TokenType::Identifier) || toToken->Word != "to") {
+			ERROR << "Excepted 'to' after string literal.\n";
+			return std::nullopt;
+		}
+
 		const Token* nameToken = nullptr;
 		if (!Accept(nameToken, TokenType::Identifier)) {
 			ERROR << "Excepted parameter or local variable name.\n";
-			return true;
-		}
-
-		const auto var = GetLocalVaraible(nameToken->Word);
-		if (!var) {
-			ERROR << "Nonexistent local variable '" << nameToken->Word << "'.\n";
-			return true;
+			return std::nullopt;
 		}
 
-		m_CurrentFunction->Builder->Lea(*var);
-		return false;
+		return StringOperand{ std::get<std::string_view>(stringToken->Data), std::get<Symbol>(nameToken->Data) };
 	}
-	bool Parser::ParseFLeaInstruction() {
-		const auto fieldName = ParseName("field name", 2, false);
-		if (!fieldName) return true;
 
-		const auto field = GetField(*fieldName);
-		if (!field) return true;
+	bool Parser::EmitInstructions() {
+		// Builders already exist, so labels added by the passes below are reserved after them
+		std::vector<std::size_t> labelCounts;
+		for (const auto& function : m_Result.Functions) {
+			labelCounts.push_back(function.Labels.size());
+		}
+		const auto reserveLabels = [this, &labelCounts]() {
+			for (std::size_t i = 0; i < m_Result.Functions.size(); ++i) {
+				Function& function = m_Result.Functions[i];
+				for (std::size_t j = labelCounts[i]; j < function.Labels.size(); ++j) {
+					function.Labels[j].Index = function.Builder->ReserveLabel(std::string(GetString(function.Labels[j].Name)));
+				}
+				labelCounts[i] = function.Labels.size();
+			}
+		};
 
-		m_CurrentFunction->Builder->FLea(*field);
-		return false;
-	}
-	bool Parser::ParseJmpInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
-		}
+		if (m_Context.OptimizationLevel >= 1) {
+			m_Context.Statistics.AddInlinedCalls(InlineFunctions(m_Result, m_Context.Symbols));
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+			std::size_t tailCallCount = 0;
+			for (auto& function : m_Result.Functions) {
+				tailCallCount += EliminateTailCalls(function, m_Result, m_Context.Symbols);
+			}
+			m_Context.Statistics.AddEliminatedTailCalls(tailCallCount);
+			reserveLabels();
 
-		m_CurrentFunction->Builder->Jmp(*label);
-		return false;
-	}
-	bool Parser::ParseJeInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
-		}
+			std::size_t eliminatedCount = 0;
+			std::size_t sharedCount = 0;
+			for (auto& function : m_Result.Functions) {
+				eliminatedCount += SimplifyControlFlow(function, m_Result);
+				eliminatedCount += FoldConstants(function);
+				eliminatedCount += OptimizePeephole(function);
+				sharedCount += ShareLocalVariables(function, m_Result);
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+				for (const auto& instruction : function.Instructions) {
+					if (instruction.Mnemonic != Mnemonic::String32) continue;
 
-		m_CurrentFunction->Builder->Je(*label);
-		return false;
-	}
-	bool Parser::ParseJneInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
+					++m_String32Literals[std::get<StringOperand>(instruction.Operand).Value];
+				}
+			}
+			m_Context.Statistics.AddEliminatedInstructions(eliminatedCount);
+			m_Context.Statistics.AddSharedLocalVariables(sharedCount);
 		}
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+		if (m_Context.Profile) {
+			for (auto& function : m_Result.Functions) {
+				const std::string_view functionName = GetString(function.Name);
 
-		m_CurrentFunction->Builder->Jne(*label);
-		return false;
-	}
-	bool Parser::ParseJaInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
+				std::unordered_map<Symbol, std::uint64_t> labelExecutionCounts;
+				for (const auto& label : function.Labels) {
+					if (const auto count = m_Context.Profile->GetLabelCount(functionName, GetString(label.Name))) {
+						labelExecutionCounts.emplace(label.Name, *count);
+					}
+				}
+				if (labelExecutionCounts.empty()) continue;
+
+				LayOutBlocks(function, m_Context.Profile->GetFunctionCount(functionName), labelExecutionCounts, m_Context.Symbols);
+			}
+			reserveLabels();
 		}
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+		if (!m_String32Literals.empty()) {
+			PrepareString32Initializers();
+		}
 
-		m_CurrentFunction->Builder->Ja(*label);
-		return false;
-	}
-	bool Parser::ParseJaeInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
+		std::vector<LoweringState> states(m_Result.Functions.size());
+		const auto lower = [this, &states](std::size_t i) {
+			states[i].Function = &m_Result.Functions[i];
+			LowerFunction(states[i]);
+		};
+		if (m_Context.ThreadPool) {
+			m_Context.ThreadPool->ParallelFor(states.size(), lower);
+		} else {
+			for (std::size_t i = 0; i < states.size(); ++i) {
+				lower(i);
+			}
 		}
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+		// Joining in order makes the byte file and the constants the same as lowering the functions one by one
+		bool hasError = false;
+		for (std::size_t i = 0; i < states.size(); ++i) {
+			JoinFunction(states[i], i);
+			hasError |= states[i].HasError;
+		}
+		if (hasError) return false;
 
-		m_CurrentFunction->Builder->Jae(*label);
-		return false;
-	}
-	bool Parser::ParseJbInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
+		m_Constants.Generate(m_Result.ByteFile);
+		for (auto& state : states) {
+			m_Constants.Relocate(state.Instructions);
+		}
+		for (auto& initializer : m_String32Initializers) {
+			m_Constants.Relocate(initializer.Instructions);
 		}
+		m_Context.Statistics.AddConstants(m_Constants.GetReferenceCount(), m_Constants.GetConstantCount());
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+		const auto emit = [this, &states](std::size_t i) {
+			if (i < states.size()) {
+				EmitInstructions(*m_Result.Functions[i].Builder, states[i].Instructions);
+			} else {
+				const auto& initializer = m_String32Initializers[i - states.size()];
+				EmitInstructions(*initializer.Builder, initializer.Instructions);
+			}
+		};
+		const std::size_t functionCount = states.size() + m_String32Initializers.size();
+		if (m_Context.ThreadPool) {
+			m_Context.ThreadPool->ParallelFor(functionCount, emit);
+		} else {
+			for (std::size_t i = 0; i < functionCount; ++i) {
+				emit(i);
+			}
+		}
+		return true;
+	}
+	void Parser::PrepareString32Initializers() {
+		// Initializers are added in the order of their first use, and lowered by the function using them first
+		if (!FindString32Module()) return;
 
-		m_CurrentFunction->Builder->Jb(*label);
-		return false;
+		for (std::size_t i = 0; i < m_Result.Functions.size(); ++i) {
+			for (const auto& instruction : m_Result.Functions[i].Instructions) {
+				if (instruction.Mnemonic != Mnemonic::String32) continue;
+
+				const std::string_view string = std::get<StringOperand>(instruction.Operand).Value;
+				if (m_String32Literals.at(string) < 2 || m_String32Functions.find(string) != m_String32Functions.end()) continue;
+
+				// '.' cannot appear in a function name, so this never collides with user functions
+				const sgn::FunctionIndex index = m_Result.ByteFile.AddFunction("string32." + std::to_string(m_String32Functions.size()), 0, true);
+				m_String32Functions.emplace(string, m_String32Initializers.size());
+				m_String32Initializers.push_back({ index, i, std::make_unique<sgn::Builder>(m_Result.ByteFile, index) });
+			}
+		}
 	}
-	bool Parser::ParseJbeInstruction() {
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted label name.\n";
-			return true;
+	void Parser::LowerFunction(LoweringState& state) {
+		// Messages from a linked function refer to the file and line it came from
+		state.Path = &m_Path;
+		state.Tokens = &m_Tokens;
+		if (const auto linkedModule = m_LinkedFunctions.find(state.Function->Name); linkedModule != m_LinkedFunctions.end()) {
+			state.Path = &linkedModule->second->SourcePath;
+			state.Tokens = &linkedModule->second->Tokens;
 		}
 
-		const auto label = GetLabel(nameToken->Word);
-		if (!label) return true;
+		state.HasError |= VerifyFunction(state);
+		for (const auto& instruction : state.Function->Instructions) {
+			state.Token = instruction.Token;
+			state.HasError |= LowerInstruction(state, instruction, state.Instructions);
+		}
+	}
+	void Parser::JoinFunction(LoweringState& state, std::size_t function) {
+		m_ErrorStream << state.Messages.str();
+		m_HasError |= state.HasError;
+		m_HasWarning |= state.HasWarning;
+
+		m_Constants.Merge(state.Constants);
+		const std::vector<std::uint32_t> indices = ReplayRequests(state.Requests);
+		const auto relocate = [&state, &indices](std::vector<LoweredInstruction>& instructions) {
+			state.Constants.Relocate(instructions);
+			RelocateRequests(indices, instructions);
+		};
 
-		m_CurrentFunction->Builder->Jbe(*label);
-		return false;
+		relocate(state.Instructions);
+		for (auto& initializer : m_String32Initializers) {
+			if (initializer.Function == function) {
+				relocate(initializer.Instructions);
+			}
+		}
+	}
+	std::uint32_t Parser::AddRequest(LoweringState& state, const ByteFileRequest& request) {
+		state.Requests.push_back(request);
+		return static_cast<std::uint32_t>(state.Requests.size() - 1);
 	}
-	bool Parser::ParseCallInstruction() {
-		const auto functionName = ParseName("function or procedure name", 1, false);
-		if (!functionName) return true;
+	std::vector<std::uint32_t> Parser::ReplayRequests(const std::vector<ByteFileRequest>& requests) {
+		std::vector<std::uint32_t> indices;
+		for (const auto& request : requests) {
+			switch (request.Kind) {
+			case ByteFileRequestKind::MapFunction:
+				if (!request.Function->MappedIndex) {
+					request.Function->MappedIndex = m_Result.ByteFile.Map(request.Module->Index, *request.Function->ExternIndex);
+				}
+				indices.push_back(static_cast<std::uint32_t>(*request.Function->MappedIndex));
+				break;
 
-		const auto function = GetFunction(*functionName);
-		if (std::holds_alternative<std::monostate>(function)) return true;
-		else if (std::holds_alternative<sgn::FunctionIndex>(function)) {
-			m_CurrentFunction->Builder->Call(std::get<sgn::FunctionIndex>(function));
-		} else if (std::holds_alternative<sgn::MappedFunctionIndex>(function)) {
-			m_CurrentFunction->Builder->Call(std::get<sgn::MappedFunctionIndex>(function));
+			case ByteFileRequestKind::MapStructure:
+				if (!request.Structure->MappedIndex) {
+					request.Structure->MappedIndex = m_Result.ByteFile.Map(request.Module->Index, *request.Structure->ExternIndex);
+				}
+				indices.push_back(static_cast<std::uint32_t>(*request.Structure->MappedIndex));
+				break;
+
+			case ByteFileRequestKind::GetTypeIndex: {
+				sgn::Type type = request.Type;
+				if (request.Structure && request.Module) {
+					if (!request.Structure->MappedIndex) {
+						request.Structure->MappedIndex = m_Result.ByteFile.Map(request.Module->Index, *request.Structure->ExternIndex);
+					}
+					type = m_Result.ByteFile.GetStructureInfo(*request.Structure->MappedIndex)->Type;
+				} else if (request.Structure) {
+					type = m_Result.ByteFile.GetStructureInfo(request.Structure->Index)->Type;
+				}
+				indices.push_back(static_cast<std::uint32_t>(m_Result.ByteFile.GetTypeIndex(type)));
+				break;
+			}
+
+			case ByteFileRequestKind::MakeArray:
+				indices.push_back(static_cast<std::uint32_t>(m_Result.ByteFile.MakeArray(static_cast<sgn::TypeIndex>(indices[request.ElementType]))));
+				break;
+			}
 		}
-		return false;
+		return indices;
 	}
-	bool Parser::ParseNewInstruction() {
-		const auto type = ParseType();
-		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
-			return true;
-		} else if (type->ElementCount) {
-			ERROR << "Array cannot be used here.\n";
-			INFO << "Use 'anew' mnemonic instead.\n";
-			return true;
+	void Parser::RelocateRequests(const std::vector<std::uint32_t>& indices, std::vector<LoweredInstruction>& instructions) {
+		for (auto& [mnemonic, operand] : instructions) {
+			if (const auto index = std::get_if<sgn::TypeIndex>(&operand)) {
+				*index = static_cast<sgn::TypeIndex>(indices[static_cast<std::uint32_t>(*index)]);
+			} else if (const auto index = std::get_if<sgn::ArrayIndex>(&operand)) {
+				*index = static_cast<sgn::ArrayIndex>(indices[static_cast<std::uint32_t>(*index)]);
+			} else if (const auto index = std::get_if<sgn::MappedFunctionIndex>(&operand)) {
+				*index = static_cast<sgn::MappedFunctionIndex>(indices[static_cast<std::uint32_t>(*index)]);
+			} else if (const auto index = std::get_if<sgn::MappedStructureIndex>(&operand)) {
+				*index = static_cast<sgn::MappedStructureIndex>(indices[static_cast<std::uint32_t>(*index)]);
+			}
 		}
-
-		m_CurrentFunction->Builder->New(m_Result.ByteFile.GetTypeIndex(type->ElementType));
-		return false;
 	}
-	bool Parser::ParseGCNewInstruction() {
-		const auto type = ParseType();
-		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
-			return true;
-		} else if (type->ElementCount) {
-			ERROR << "Array cannot be used here.\n";
-			INFO << "Use 'agcnew' mnemonic instead.\n";
-			return true;
+	void Parser::EmitInstructions(sgn::Builder& builder, const std::vector<LoweredInstruction>& instructions) {
+		for (const auto& [mnemonic, operand] : instructions) {
+			switch (mnemonic) {
+			case Mnemonic::Nop: builder.Nop(); break;
+
+			case Mnemonic::Push:
+				if (std::holds_alternative<sgn::IntConstantIndex>(operand)) {
+					builder.Push(std::get<sgn::IntConstantIndex>(operand));
+				} else if (std::holds_alternative<sgn::LongConstantIndex>(operand)) {
+					builder.Push(std::get<sgn::LongConstantIndex>(operand));
+				} else if (std::holds_alternative<sgn::SingleConstantIndex>(operand)) {
+					builder.Push(std::get<sgn::SingleConstantIndex>(operand));
+				} else if (std::holds_alternative<sgn::DoubleConstantIndex>(operand)) {
+					builder.Push(std::get<sgn::DoubleConstantIndex>(operand));
+				} else if (std::holds_alternative<sgn::StructureIndex>(operand)) {
+					builder.Push(std::get<sgn::StructureIndex>(operand));
+				} else {
+					builder.Push(std::get<sgn::MappedStructureIndex>(operand));
+				}
+				break;
+			case Mnemonic::Pop: builder.Pop(); break;
+			case Mnemonic::Load: builder.Load(std::get<sgn::LocalVariableIndex>(operand)); break;
+			case Mnemonic::Store: builder.Store(std::get<sgn::LocalVariableIndex>(operand)); break;
+			case Mnemonic::Lea: builder.Lea(std::get<sgn::LocalVariableIndex>(operand)); break;
+			case Mnemonic::FLea: builder.FLea(std::get<sgn::FieldIndex>(operand)); break;
+			case Mnemonic::TLoad: builder.TLoad(); break;
+			case Mnemonic::TStore: builder.TStore(); break;
+			case Mnemonic::Copy: builder.Copy(); break;
+			case Mnemonic::Swap: builder.Swap(); break;
+
+			case Mnemonic::Add: builder.Add(); break;
+			case Mnemonic::Sub: builder.Sub(); break;
+			case Mnemonic::Mul: builder.Mul(); break;
+			case Mnemonic::IMul: builder.IMul(); break;
+			case Mnemonic::Div: builder.Div(); break;
+			case Mnemonic::IDiv: builder.IDiv(); break;
+			case Mnemonic::Mod: builder.Mod(); break;
+			case Mnemonic::IMod: builder.IMod(); break;
+			case Mnemonic::Neg: builder.Neg(); break;
+			case Mnemonic::Inc: builder.Inc(); break;
+			case Mnemonic::Dec: builder.Dec(); break;
+
+			case Mnemonic::And: builder.And(); break;
+			case Mnemonic::Or: builder.Or(); break;
+			case Mnemonic::Xor: builder.Xor(); break;
+			case Mnemonic::Not: builder.Not(); break;
+			case Mnemonic::Shl: builder.Shl(); break;
+			case Mnemonic::Sal: builder.Sal(); break;
+			case Mnemonic::Shr: builder.Shr(); break;
+			case Mnemonic::Sar: builder.Sar(); break;
+
+			case Mnemonic::Cmp: builder.Cmp(); break;
+			case Mnemonic::ICmp: builder.ICmp(); break;
+			case Mnemonic::Jmp: builder.Jmp(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Je: builder.Je(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Jne: builder.Jne(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Ja: builder.Ja(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Jae: builder.Jae(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Jb: builder.Jb(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Jbe: builder.Jbe(std::get<sgn::LabelIndex>(operand)); break;
+			case Mnemonic::Call:
+				if (std::holds_alternative<sgn::FunctionIndex>(operand)) {
+					builder.Call(std::get<sgn::FunctionIndex>(operand));
+				} else {
+					builder.Call(std::get<sgn::MappedFunctionIndex>(operand));
+				}
+				break;
+			case Mnemonic::Ret: builder.Ret(); break;
+
+			case Mnemonic::ToI: builder.ToI(); break;
+			case Mnemonic::ToL: builder.ToL(); break;
+			case Mnemonic::ToSi: builder.ToSi(); break;
+			case Mnemonic::ToD: builder.ToD(); break;
+			case Mnemonic::ToP: builder.ToP(); break;
+
+			case Mnemonic::Null: builder.Null(); break;
+			case Mnemonic::New: builder.New(std::get<sgn::TypeIndex>(operand)); break;
+			case Mnemonic::Delete: builder.Delete(); break;
+			case Mnemonic::GCNull: builder.GCNull(); break;
+			case Mnemonic::GCNew: builder.GCNew(std::get<sgn::TypeIndex>(operand)); break;
+			case Mnemonic::APush: builder.APush(std::get<sgn::ArrayIndex>(operand)); break;
+			case Mnemonic::ANew: builder.ANew(std::get<sgn::ArrayIndex>(operand)); break;
+			case Mnemonic::AGCNew: builder.AGCNew(std::get<sgn::ArrayIndex>(operand)); break;
+			case Mnemonic::ALea: builder.ALea(); break;
+			case Mnemonic::Count: builder.Count(); break;
+
+			case Mnemonic::Label: builder.AddLabel(std::string(std::get<std::string_view>(operand))); break;
+
+			default: break;
+			}
 		}
+	}
 
-		m_CurrentFunction->Builder->GCNew(m_Result.ByteFile.GetTypeIndex(type->ElementType));
-		return false;
+	const Token& Parser::GetToken(const LoweringState& state) const noexcept {
+		if (state.Token >= state.Tokens->size()) return m_EmptyToken;
+		else return (*state.Tokens)[state.Token];
 	}
-	bool Parser::ParseAPushInstruction() {
-		const auto type = ParseType();
-		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
-			return true;
-		} else if (!type->ElementCount) {
-			ERROR << "Only array can be used here.\n";
-			INFO << "Use 'push' mnemonic instead.\n";
-			return true;
-		} else if (*type->ElementCount != 0) {
-			ERROR << "Array's length cannot be used here.\n";
-			return true;
+	bool Parser::VerifyFunction(LoweringState& state) {
+		const StackInfo stackInfo = VerifyStack(*state.Function, m_Result);
+
+		bool hasError = false;
+		for (const auto& message : stackInfo.Messages) {
+			state.Token = state.Function->Instructions[message.Instruction].Token;
+			if (message.IsError) {
+				STATE_ERROR << message.Message << ".\n";
+				hasError = true;
+			} else {
+				STATE_WARNING << message.Message << ".\n";
+			}
 		}
 
-		m_CurrentFunction->Builder->APush(m_Result.ByteFile.MakeArray(m_Result.ByteFile.GetTypeIndex(type->ElementType)));
-		return false;
+		state.Function->MaxStackDepth = stackInfo.MaxDepth;
+		if (stackInfo.MaxDepth) {
+			m_Context.Statistics.AddVerifiedFunction(*stackInfo.MaxDepth);
+		}
+		return hasError;
 	}
-	bool Parser::ParseANewInstruction() {
-		const auto type = ParseType();
-		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
-			return true;
-		} else if (!type->ElementCount) {
-			ERROR << "Only array can be used here.\n";
-			INFO << "Use 'new' mnemonic instead.\n";
-			return true;
-		} else if (*type->ElementCount != 0) {
-			ERROR << "Array's length cannot be used here.\n";
-			return true;
+	bool Parser::LowerInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output) {
+		switch (instruction.Mnemonic) {
+		case Mnemonic::Push: return LowerPushInstruction(state, instruction, output);
+		case Mnemonic::Load:
+		case Mnemonic::Store:
+		case Mnemonic::Lea: return LowerLocalVariableInstruction(state, instruction, output);
+		case Mnemonic::FLea: {
+			const auto field = GetField(state, std::get<Name>(instruction.Operand));
+			if (!field) return true;
+
+			output.push_back({ Mnemonic::FLea, *field });
+			return false;
 		}
 
-		m_CurrentFunction->Builder->ANew(m_Result.ByteFile.MakeArray(m_Result.ByteFile.GetTypeIndex(type->ElementType)));
-		return false;
+		case Mnemonic::Jmp:
+		case Mnemonic::Je:
+		case Mnemonic::Jne:
+		case Mnemonic::Ja:
+		case Mnemonic::Jae:
+		case Mnemonic::Jb:
+		case Mnemonic::Jbe: {
+			const auto label = GetLabel(state, std::get<Symbol>(instruction.Operand));
+			if (!label) return true;
+
+			output.push_back({ instruction.Mnemonic, *label });
+			return false;
+		}
+		case Mnemonic::Call: {
+			const auto function = GetFunction(state, std::get<Name>(instruction.Operand));
+			if (std::holds_alternative<std::monostate>(function)) return true;
+			else if (std::holds_alternative<sgn::FunctionIndex>(function)) {
+				output.push_back({ Mnemonic::Call, std::get<sgn::FunctionIndex>(function) });
+			} else {
+				output.push_back({ Mnemonic::Call, std::get<sgn::MappedFunctionIndex>(function) });
+			}
+			return false;
+		}
+
+		case Mnemonic::New:
+		case Mnemonic::GCNew:
+		case Mnemonic::APush:
+		case Mnemonic::ANew:
+		case Mnemonic::AGCNew: return LowerTypeInstruction(state, instruction, output);
+
+		case Mnemonic::String32: return LowerString32Statement(state, instruction, output);
+		case Mnemonic::Label:
+			output.push_back({ Mnemonic::Label, GetString(std::get<Symbol>(instruction.Operand)) });
+			return false;
+
+		default:
+			output.push_back({ instruction.Mnemonic });
+			return false;
+		}
 	}
-	bool Parser::ParseAGCNewInstruction() {
-		const auto type = ParseType();
-		if (!type) return true;
-		else if (type->ElementType == nullptr) {
-			ERROR << "Nonexistent type '" << type->ElementTypeName << "'.\n";
-			return true;
-		} else if (!type->ElementCount) {
-			ERROR << "Only array can be used here.\n";
-			INFO << "Use 'gcnew' mnemonic instead.\n";
+	bool Parser::LowerPushInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output) {
+		if (std::holds_alternative<std::uint32_t>(instruction.Operand)) {
+			output.push_back({ Mnemonic::Push, state.Constants.AddIntConstant(std::get<std::uint32_t>(instruction.Operand)) });
+			return false;
+		} else if (std::holds_alternative<std::uint64_t>(instruction.Operand)) {
+			output.push_back({ Mnemonic::Push, state.Constants.AddLongConstant(std::get<std::uint64_t>(instruction.Operand)) });
+			return false;
+		} else if (std::holds_alternative<float>(instruction.Operand)) {
+			output.push_back({ Mnemonic::Push, state.Constants.AddSingleConstant(std::get<float>(instruction.Operand)) });
+			return false;
+		} else if (std::holds_alternative<double>(instruction.Operand)) {
+			output.push_back({ Mnemonic::Push, state.Constants.AddDoubleConstant(std::get<double>(instruction.Operand)) });
+			return false;
+		}
+
+		const auto type = GetType(state, std::get<Name>(instruction.Operand));
+		if (type && type->Structure) {
+			if (type->Module) {
+				output.push_back({ Mnemonic::Push, static_cast<sgn::MappedStructureIndex>(AddRequest(state,
+					{ ByteFileRequestKind::MapStructure, type->Module, nullptr, type->Structure })) });
+			} else {
+				output.push_back({ Mnemonic::Push, type->Structure->Index });
+			}
+			return false;
+		} else {
+			STATE_ERROR << "Excepted literal or structure name.\n";
 			return true;
-		} else if (*type->ElementCount != 0) {
-			ERROR << "Array's length cannot be used here.\n";
+		}
+	}
+	bool Parser::LowerLocalVariableInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output) {
+		const Symbol name = std::get<Symbol>(instruction.Operand);
+
+		auto var = GetLocalVaraible(state, name);
+		if (!var && instruction.Mnemonic == Mnemonic::Store) {
+			var = state.Function->Builder->AddLocalVariable();
+			state.Function->AddLocalVariable(LocalVariable{ name, *var });
+		} else if (!var) {
+			STATE_ERROR << "Nonexistent local variable '" << GetString(name) << "'.\n";
 			return true;
 		}
 
-		m_CurrentFunction->Builder->AGCNew(m_Result.ByteFile.MakeArray(m_Result.ByteFile.GetTypeIndex(type->ElementType)));
+		output.push_back({ instruction.Mnemonic, *var });
 		return false;
 	}
-	bool Parser::ParseString32Statement() {
-		if (!m_Result.HasDependency("/std/string.sba")) {
-			ERROR << "Required to import \"/std/string.sba\" module.\n";
+	bool Parser::LowerTypeInstruction(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output) {
+		const Type& type = std::get<Type>(instruction.Operand);
+		const auto elementType = GetType(state, type.ElementTypeName);
+		if (!elementType) {
+			STATE_ERROR << "Nonexistent type '" << GetString(type.ElementTypeName.Full) << "'.\n";
 			return true;
 		}
 
-		const Token* stringToken = nullptr;
-		if (!Accept(stringToken, TokenType::String)) {
-			ERROR << "Excepted string literal.\n";
-			return true;
+		const std::uint32_t typeIndex = AddRequest(state,
+			{ ByteFileRequestKind::GetTypeIndex, elementType->Module, nullptr, elementType->Structure, elementType->Type });
+		if (type.ElementCount) {
+			output.push_back({ instruction.Mnemonic, static_cast<sgn::ArrayIndex>(AddRequest(state,
+				{ ByteFileRequestKind::MakeArray, nullptr, nullptr, nullptr, nullptr, typeIndex })) });
+		} else {
+			output.push_back({ instruction.Mnemonic, static_cast<sgn::TypeIndex>(typeIndex) });
 		}
-
-		const Token* toToken = nullptr;
-		if (!Accept(toToken, TokenType::Identifier) || std::get<std::string>(toToken->Data) != "to") {
-			ERROR << "Excepted 'to' after string literal.\n";
+		return false;
+	}
+	bool Parser::LowerString32Statement(LoweringState& state, const Instruction& instruction, std::vector<LoweredInstruction>& output) {
+		ExternModule* const module = FindString32Module();
+		if (!module) {
+			STATE_ERROR << "Required to import \"/std/string.sba\" module.\n";
 			return true;
 		}
 
-		const Token* nameToken = nullptr;
-		if (!Accept(nameToken, TokenType::Identifier)) {
-			ERROR << "Excepted parameter or local variable name.\n";
-			return true;
-		}
+		const StringOperand& operand = std::get<StringOperand>(instruction.Operand);
 
-		auto var = GetLocalVaraible(nameToken->Word);
+		auto var = GetLocalVaraible(state, operand.LocalVariable);
 		if (!var) {
-			var = m_CurrentFunction->Builder->AddLocalVariable();
-			m_CurrentFunction->LocalVariables.push_back(LocalVariable{ nameToken->Word, *var });
+			var = state.Function->Builder->AddLocalVariable();
+			state.Function->AddLocalVariable(LocalVariable{ operand.LocalVariable, *var });
 		}
 
-		const auto module = m_Result.FindDependency("/std/string.sba");
-		const auto structure = module->Assembly.FindStructure("String32");
-		if (!structure->MappedIndex) {
-			structure->MappedIndex = m_Result.ByteFile.Map(module->Index, *structure->ExternIndex);
+		const auto structure = module->Assembly.FindStructure(m_Context.Symbols.Intern("String32"));
+		output.push_back({ Mnemonic::Push, static_cast<sgn::MappedStructureIndex>(AddRequest(state,
+			{ ByteFileRequestKind::MapStructure, module, nullptr, &*structure })) });
+		output.push_back({ Mnemonic::Store, *var });
+
+		output.push_back({ Mnemonic::Lea, *var });
+		output.push_back({ Mnemonic::FLea, structure->Fields[0].Index });
+
+		const std::string_view string = operand.Value;
+		const auto lengthConstant = state.Constants.AddLongConstant(static_cast<std::uint64_t>(string.size()));
+		if (const auto iter = m_String32Functions.find(string); iter != m_String32Functions.end()) {
+			String32Initializer& initializer = m_String32Initializers[iter->second];
+			if (&m_Result.Functions[initializer.Function] == state.Function && initializer.Instructions.empty()) {
+				LowerString32Array(state, string, lengthConstant, initializer.Instructions);
+				initializer.Instructions.push_back({ Mnemonic::Ret });
+			}
+			output.push_back({ Mnemonic::Call, initializer.Index });
+		} else {
+			LowerString32Array(state, string, lengthConstant, output);
 		}
 
-		m_CurrentFunction->Builder->Push(*structure->MappedIndex);
-		m_CurrentFunction->Builder->Store(*var);
+		output.push_back({ Mnemonic::TStore });
+
+		output.push_back({ Mnemonic::Lea, *var });
+		output.push_back({ Mnemonic::FLea, structure->Fields[1].Index });
+		output.push_back({ Mnemonic::Push, lengthConstant });
+		output.push_back({ Mnemonic::TStore });
 
-		m_CurrentFunction->Builder->Lea(*var);
-		m_CurrentFunction->Builder->FLea(structure->Fields[0].Index);
+		output.push_back({ Mnemonic::Lea, *var });
+		output.push_back({ Mnemonic::FLea, structure->Fields[2].Index });
+		output.push_back({ Mnemonic::Push, lengthConstant });
+		output.push_back({ Mnemonic::TStore });
 
-		const std::string& string = std::get<std::string>(stringToken->Data);
+		return false;
+	}
+	void Parser::LowerString32Array(LoweringState& state, std::string_view string, sgn::LongConstantIndex lengthConstant, std::vector<LoweredInstruction>& output) {
 		const std::uint64_t length = static_cast<std::uint64_t>(string.size());
-		const auto lengthConstant = m_Result.ByteFile.AddLongConstant(length);
-		m_CurrentFunction->Builder->Push(lengthConstant);
-		m_CurrentFunction->Builder->ANew(m_Result.ByteFile.MakeArray(m_Result.ByteFile.GetTypeIndex(svm::IntType)));
-		
+		const std::uint32_t typeIndex = AddRequest(state, { ByteFileRequestKind::GetTypeIndex, nullptr, nullptr, nullptr, svm::IntType });
+		output.push_back({ Mnemonic::Push, lengthConstant });
+		output.push_back({ Mnemonic::ANew, static_cast<sgn::ArrayIndex>(AddRequest(state,
+			{ ByteFileRequestKind::MakeArray, nullptr, nullptr, nullptr, nullptr, typeIndex })) });
+
 		for (std::uint64_t i = 0; i < length; ++i) {
-			m_CurrentFunction->Builder->Copy();
-			m_CurrentFunction->Builder->Push(m_Result.ByteFile.AddLongConstant(i));
-			m_CurrentFunction->Builder->ALea();
-			m_CurrentFunction->Builder->Push(m_Result.ByteFile.AddIntConstant(string[i]));
-			m_CurrentFunction->Builder->TStore();
+			output.push_back({ Mnemonic::Copy });
+			output.push_back({ Mnemonic::Push, state.Constants.AddLongConstant(i) });
+			output.push_back({ Mnemonic::ALea });
+			output.push_back({ Mnemonic::Push, state.Constants.AddIntConstant(string[i]) });
+			output.push_back({ Mnemonic::TStore });
 		}
+	}
+	ExternModule* Parser::FindString32Module() {
+		const Symbol modulePath = m_Context.Symbols.Intern("/std/string.sba");
+		if (IsLinkedStatically()) return FindExternModule(modulePath);
+		else if (const auto dependency = m_Result.FindDependency(modulePath); dependency != m_Result.Dependencies.end()) return &*dependency;
+		else return nullptr;
+	}
 
-		m_CurrentFunction->Builder->TStore();
+	ExternModule* Parser::GetDependency(LoweringState& state, Symbol nameSpace) {
+		if (IsLinkedStatically()) {
+			// Names rewritten by GetLinkedName refer to standard modules by their path
+			if (const auto module = FindExternModule(nameSpace)) return module;
+		}
 
-		m_CurrentFunction->Builder->Lea(*var);
-		m_CurrentFunction->Builder->FLea(structure->Fields[1].Index);
-		m_CurrentFunction->Builder->Push(lengthConstant);
-		m_CurrentFunction->Builder->TStore();
+		const auto dependency = m_Result.FindDependencyByNameSpace(nameSpace);
+		if (dependency == m_Result.Dependencies.end()) {
+			STATE_ERROR << "Nonexistent namespace '" << GetString(nameSpace) << "'.\n";
+			return nullptr;
+		} else if (IsLinkedStatically() && IsNativeModule(*dependency)) return FindExternModule(dependency->Path);
+		else return &*dependency;
+	}
+	std::optional<Parser::TypeReference> Parser::GetType(LoweringState& state, const Name& name) {
+		auto assembly = &m_Result;
+		ExternModule* externModule = nullptr;
 
-		m_CurrentFunction->Builder->Lea(*var);
-		m_CurrentFunction->Builder->FLea(structure->Fields[2].Index);
-		m_CurrentFunction->Builder->Push(lengthConstant);
-		m_CurrentFunction->Builder->TStore();
+		if (name.NameSpace != Symbol::Empty) {
+			externModule = GetDependency(state, name.NameSpace);
+			if (!externModule) return std::nullopt;
 
-		return false;
-	}
+			assembly = &externModule->Assembly;
+		}
 
-	std::optional<sgn::FieldIndex> Parser::GetField(const Name& name) {
+		const auto& fundamental = GetFundamentalTypes();
+		const auto iter = fundamental.find(GetString(name.Identifier));
+		if (iter != fundamental.end()) {
+			if (externModule) {
+				STATE_WARNING << "Use just '" << GetString(name.Identifier) << "' instead of '" << GetString(name.Full) << "'.\n";
+			}
+			return TypeReference{ svm::GetFundamentalType(iter->second->Code) };
+		}
+
+		Symbol identifier = name.Identifier;
+		if (externModule && IsLinkedStatically() && !IsNativeModule(*externModule)) {
+			identifier = m_Context.Symbols.Concat(externModule->Path, identifier);
+			externModule = nullptr;
+			assembly = &m_Result;
+		}
+
+		const auto structure = assembly->FindStructure(identifier);
+		if (structure == assembly->Structures.end()) {
+			STATE_ERROR << "Nonexistent structure '" << GetString(IsLinkedStatically() ? name.Full : name.Identifier) << "'.\n";
+			return std::nullopt;
+		}
+		return TypeReference{ nullptr, &*structure, externModule };
+	}
+	std::optional<sgn::FieldIndex> Parser::GetField(LoweringState& state, const Name& name) {
 		auto assembly = &m_Result;
 
-		if (!name.NameSpace.empty()) {
-			const auto dependency = m_Result.FindDependencyByNameSpace(name.NameSpace);
-			if (dependency == m_Result.Dependencies.end()) {
-				ERROR << "Nonexistent namespace '" << name.NameSpace << "'.\n";
-				return std::nullopt;
-			}
+		if (name.NameSpace != Symbol::Empty) {
+			const auto dependency = GetDependency(state, name.NameSpace);
+			if (!dependency) return std::nullopt;
+			else if (IsLinkedStatically() && !IsNativeModule(*dependency)) return GetField(state, Name{ Symbol::Empty,
+				m_Context.Symbols.Concat(dependency->Path, name.Identifier), name.Member, name.Full });
 
 			assembly = &dependency->Assembly;
 		}
 
-		const auto dot = name.Identifier.find('.');
-
-		const auto structureName = name.Identifier.substr(0, dot);
-		const auto structure = assembly->FindStructure(structureName);
+		const auto structure = assembly->FindStructure(name.Identifier);
 		if (structure == assembly->Structures.end()) {
-			ERROR << "Nonexistent structure '" << structureName << "'.\n";
+			STATE_ERROR << "Nonexistent structure '" << GetString(name.Identifier) << "'.\n";
 			return std::nullopt;
 		}
 
-		const auto fieldName = name.Identifier.substr(dot + 1);
-		const auto field = structure->FindField(fieldName);
+		const auto field = structure->FindField(name.Member);
 		if (field == structure->Fields.end()) {
-			ERROR << "Nonexistent field '" << name.Identifier << "'.\n";
+			STATE_ERROR << "Nonexistent field '" << GetString(name.Identifier) << '.' << GetString(name.Member) << "'.\n";
 			return std::nullopt;
 		}
 
 		return field->Index;
 	}
-	std::variant<std::monostate, sgn::FunctionIndex, sgn::MappedFunctionIndex> sam::Parser::GetFunction(const Name& name) {
+	std::variant<std::monostate, sgn::FunctionIndex, sgn::MappedFunctionIndex> sam::Parser::GetFunction(LoweringState& state, const Name& name) {
 		auto assembly = &m_Result;
 		ExternModule* externModule = nullptr;
 
-		if (!name.NameSpace.empty()) {
-			const auto dependency = m_Result.FindDependencyByNameSpace(name.NameSpace);
-			if (dependency == m_Result.Dependencies.end()) {
-				ERROR << "Nonexistent namespace '" << name.NameSpace << "'.\n";
-				return std::monostate{};
-			}
+		if (name.NameSpace != Symbol::Empty) {
+			const auto dependency = GetDependency(state, name.NameSpace);
+			if (!dependency) return std::monostate{};
+			else if (IsLinkedStatically() && !IsNativeModule(*dependency)) return GetFunction(state, Name{ Symbol::Empty,
+				m_Context.Symbols.Concat(dependency->Path, name.Identifier), name.Member, name.Full });
 
-			externModule = &*dependency;
+			externModule = dependency;
 			assembly = &dependency->Assembly;
 		}
 
 		const auto function = assembly->FindFunction(name.Identifier);
 		if (function == assembly->Functions.end()) {
-			ERROR << "Nonexistent function or procedure '" << name.Identifier << "'.\n";
+			STATE_ERROR << "Nonexistent function or procedure '" << GetString(IsLinkedStatically() ? name.Full : name.Identifier) << "'.\n";
 			return std::monostate{};
-		} else if (name.Identifier == "entrypoint") {
-			ERROR << "Noncallable procedure 'entrypoint'.\n";
+		} else if (name.Identifier == Symbol::Entrypoint) {
+			STATE_ERROR << "Noncallable procedure 'entrypoint'.\n";
 			return std::monostate{};
 		}
 
 		if (externModule) {
-			if (!function->MappedIndex) {
-				function->MappedIndex = m_Result.ByteFile.Map(externModule->Index, *function->ExternIndex);
-			}
-			return *function->MappedIndex;
+			return static_cast<sgn::MappedFunctionIndex>(AddRequest(state, { ByteFileRequestKind::MapFunction, externModule, &*function }));
 		} else {
 			return function->Index;
 		}
 	}
-	std::optional<sgn::LabelIndex> Parser::GetLabel(const std::string& name) {
-		const auto iter = m_CurrentFunction->FindLabel(name);
-		if (iter == m_CurrentFunction->Labels.end()) {
-			ERROR << "Nonexistent label '" << name << "'.\n";
+	std::optional<sgn::LabelIndex> Parser::GetLabel(LoweringState& state, Symbol name) {
+		const auto iter = state.Function->FindLabel(name);
+		if (iter == state.Function->Labels.end()) {
+			STATE_ERROR << "Nonexistent label '" << GetString(name) << "'.\n";
 			return std::nullopt;
 		} else return iter->Index;
 	}
-	std::optional<sgn::LocalVariableIndex> Parser::GetLocalVaraible(const std::string& name) {
-		const auto iter = m_CurrentFunction->FindLocalVariable(name);
-		if (iter == m_CurrentFunction->LocalVariables.end()) return std::nullopt;
+	std::optional<sgn::LocalVariableIndex> Parser::GetLocalVaraible(LoweringState& state, Symbol name) {
+		const auto iter = state.Function->FindLocalVariable(name);
+		if (iter == state.Function->LocalVariables.end()) return std::nullopt;
 		else return iter->Index;
 	}
 }
\ No newline at end of file
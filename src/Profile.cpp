@@ -0,0 +1,68 @@
+#include <sam/Profile.hpp>
+
+#include <sam/ModuleCache.hpp>
+#include <sam/Source.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <vector>
+
+namespace sam {
+	bool Profile::Load(const std::string& path, std::ostream& errorStream) {
+		Source source;
+		if (!source.Open(path)) {
+			errorStream << "Error: Failed to open '" << path << "'.\n";
+			return false;
+		}
+
+		std::string_view data = source.GetData();
+		m_ContentHash = ModuleCache::Hash(data);
+
+		for (std::size_t lineNum = 1; !data.empty(); ++lineNum) {
+			std::string_view line = data.substr(0, data.find('\n'));
+			data.remove_prefix(std::min(line.size() + 1, data.size()));
+			line = line.substr(0, line.find(';'));
+
+			std::vector<std::string_view> words;
+			while (true) {
+				const std::size_t begin = line.find_first_not_of(" \t\r");
+				if (begin == std::string_view::npos) break;
+
+				const std::size_t end = std::min(line.find_first_of(" \t\r", begin), line.size());
+				words.push_back(line.substr(begin, end - begin));
+				line.remove_prefix(end);
+			}
+			if (words.empty()) continue;
+
+			std::uint64_t count = 0;
+			const std::string_view countWord = words.back();
+			const auto [countEnd, error] = std::from_chars(countWord.data(), countWord.data() + countWord.size(), count);
+			if (words.size() < 2 || words.size() > 3 || error != std::errc() || countEnd != countWord.data() + countWord.size()) {
+				errorStream << "In file '" << path << "':\n    Error: Line " << lineNum << ", Excepted '<Function> [Label] <Count>'.\n";
+				return false;
+			}
+
+			if (words.size() == 2) {
+				m_Functions[std::string(words[0])] += count;
+			} else {
+				m_Labels[std::string(words[0]).append(" ").append(words[1])] += count;
+			}
+		}
+		return true;
+	}
+
+	std::optional<std::uint64_t> Profile::GetFunctionCount(std::string_view function) const {
+		const auto iter = m_Functions.find(std::string(function));
+		if (iter == m_Functions.end()) return std::nullopt;
+		else return iter->second;
+	}
+	std::optional<std::uint64_t> Profile::GetLabelCount(std::string_view function, std::string_view label) const {
+		const auto iter = m_Labels.find(std::string(function).append(" ").append(label));
+		if (iter == m_Labels.end()) return std::nullopt;
+		else return iter->second;
+	}
+	std::uint64_t Profile::GetContentHash() const noexcept {
+		return m_ContentHash;
+	}
+}
\ No newline at end of file
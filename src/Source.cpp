@@ -0,0 +1,59 @@
+#include <sam/Source.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace sam {
+	Source::Source(std::string data) noexcept
+		: m_Data(std::move(data)) {}
+	Source::~Source() {
+#ifndef _WIN32
+		if (m_MappedData) {
+			munmap(const_cast<char*>(m_MappedData), m_MappedSize);
+		}
+#endif
+	}
+
+	bool Source::Open(const std::string& path) {
+#ifndef _WIN32
+		if (const int file = open(path.c_str(), O_RDONLY); file != -1) {
+			struct stat status;
+			if (fstat(file, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+				const std::size_t size = static_cast<std::size_t>(status.st_size);
+				if (void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0); data != MAP_FAILED) {
+					madvise(data, size, MADV_SEQUENTIAL);
+					m_MappedData = static_cast<const char*>(data);
+					m_MappedSize = size;
+				}
+			}
+			close(file);
+			if (m_MappedData) return true;
+		}
+#endif
+
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream) return false;
+
+		m_Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		return true;
+	}
+	bool Source::IsMapped() const noexcept {
+		return m_MappedData != nullptr;
+	}
+
+	std::string_view Source::GetData() const noexcept {
+		if (m_MappedData) return { m_MappedData, m_MappedSize };
+		else return m_Data;
+	}
+	std::string_view Source::AddText(std::string text) {
+		return m_Texts.emplace_back(std::move(text));
+	}
+}
\ No newline at end of file
@@ -43,18 +43,13 @@ namespace sam {
 		}
 	}
 
-	void Trim(std::string& string) noexcept {
+	void Trim(std::string_view& string) noexcept {
 		std::size_t beginOffset = 0;
 		std::size_t rbeginOffset = 0;
 
 		while (string.size() > rbeginOffset && std::isspace(string[string.size() - rbeginOffset - 1])) ++rbeginOffset;
 		while (string.size() > beginOffset + rbeginOffset && std::isspace(string[beginOffset])) ++beginOffset;
 
-		if (beginOffset) {
-			string.erase(string.begin(), string.begin() + beginOffset);
-		}
-		if (rbeginOffset) {
-			string.erase(string.end() - rbeginOffset, string.end());
-		}
+		string = string.substr(beginOffset, string.size() - beginOffset - rbeginOffset);
 	}
 }
\ No newline at end of file
@@ -1,17 +1,19 @@
 #include <sam/Structure.hpp>
 
-#include <algorithm>
+#include <utility>
 
 namespace sam {
-	std::vector<Field>::iterator Structure::FindField(const std::string& name) {
-		return std::find_if(Fields.begin(), Fields.end(), [name](const Field& field) {
-			return field.Name == name;
-		});
+	Field& Structure::AddField(Field field) {
+		FieldNames.Add(field.Name, Fields.size());
+		return Fields.emplace_back(std::move(field));
 	}
-	Field& Structure::GetField(const std::string& name) {
+	std::vector<Field>::iterator Structure::FindField(Symbol name) {
+		return FieldNames.Find(Fields, name);
+	}
+	Field& Structure::GetField(Symbol name) {
 		return *FindField(name);
 	}
-	bool Structure::HasField(const std::string& name) {
+	bool Structure::HasField(Symbol name) {
 		return FindField(name) != Fields.end();
 	}
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <sam/SymbolTable.hpp>
+
+namespace sam {
+	SymbolTable::SymbolTable() {
+		Intern("");
+		Intern("entrypoint");
+	}
+
+	Symbol SymbolTable::Intern(std::string_view string) {
+		{
+			const auto lock = LockShared();
+			if (const auto iter = m_Symbols.find(string); iter != m_Symbols.end()) return iter->second;
+		}
+
+		const auto lock = LockUnique();
+		if (const auto iter = m_Symbols.find(string); iter != m_Symbols.end()) return iter->second;
+
+		const Symbol symbol = static_cast<Symbol>(m_Strings.size());
+		m_Symbols.emplace(m_Strings.emplace_back(string), symbol);
+		return symbol;
+	}
+	Symbol SymbolTable::Concat(Symbol prefix, Symbol suffix) {
+		const std::uint64_t key = static_cast<std::uint64_t>(prefix) << 32 | static_cast<std::uint32_t>(suffix);
+		{
+			const auto lock = LockShared();
+			if (const auto iter = m_Concatenations.find(key); iter != m_Concatenations.end()) return iter->second;
+		}
+
+		std::string string(GetString(prefix));
+		string.push_back('.');
+		string.append(GetString(suffix));
+
+		const Symbol symbol = Intern(string);
+		const auto lock = LockUnique();
+		m_Concatenations.emplace(key, symbol);
+		return symbol;
+	}
+	std::string_view SymbolTable::GetString(Symbol symbol) const noexcept {
+		const auto lock = LockShared();
+		return m_Strings[static_cast<std::uint32_t>(symbol)];
+	}
+	void SymbolTable::SetConcurrent(bool isConcurrent) noexcept {
+		m_IsConcurrent = isConcurrent;
+	}
+
+	std::shared_lock<std::shared_mutex> SymbolTable::LockShared() const {
+		if (m_IsConcurrent) return std::shared_lock(m_Mutex);
+		else return {};
+	}
+	std::unique_lock<std::shared_mutex> SymbolTable::LockUnique() {
+		if (m_IsConcurrent) return std::unique_lock(m_Mutex);
+		else return {};
+	}
+}
\ No newline at end of file
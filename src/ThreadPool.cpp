@@ -0,0 +1,98 @@
+#include <sam/ThreadPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace sam {
+	ThreadPool::ThreadPool(std::size_t workerCount) {
+		m_Workers.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i) {
+			m_Workers.emplace_back(&ThreadPool::Work, this);
+		}
+	}
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& worker : m_Workers) {
+			worker.join();
+		}
+	}
+
+	std::size_t ThreadPool::GetWorkerCount() const noexcept {
+		return m_Workers.size();
+	}
+
+	void ThreadPool::Add(std::function<void()> task) {
+		Add(std::move(task), nullptr);
+	}
+	void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& function) {
+		std::atomic<std::size_t> next = 0;
+		const auto run = [&]() {
+			for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+				function(i);
+			}
+		};
+
+		const std::size_t helperCount = std::min(m_Workers.size(), count > 0 ? count - 1 : 0);
+		std::atomic<std::size_t> runningHelpers = helperCount;
+		for (std::size_t i = 0; i < helperCount; ++i) {
+			Add([&]() {
+				run();
+				runningHelpers.fetch_sub(1, std::memory_order_release);
+			}, &next);
+		}
+
+		run();
+
+		// Helpers reference this stack frame, so wait for all of them. Running the helpers no worker has taken yet
+		// keeps nested calls from deadlocking when every worker is waiting. Tasks of other calls are not run here,
+		// since they may wait for a module this thread is loading.
+		while (runningHelpers.load(std::memory_order_acquire) != 0) {
+			if (!RunPendingTask(&next)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void ThreadPool::Add(std::function<void()> task, const void* group) {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Tasks.push_back({ std::move(task), group });
+		}
+		m_Condition.notify_one();
+	}
+	void ThreadPool::Work() {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [this] { return m_IsStopping || !m_Tasks.empty(); });
+				if (m_Tasks.empty()) return;
+
+				task = std::move(m_Tasks.front().Function);
+				m_Tasks.pop_front();
+			}
+			task();
+		}
+	}
+	bool ThreadPool::RunPendingTask(const void* group) {
+		std::function<void()> task;
+		{
+			std::lock_guard lock(m_Mutex);
+			const auto iter = std::find_if(m_Tasks.begin(), m_Tasks.end(), [group](const Task& task) {
+				return task.Group == group;
+			});
+			if (iter == m_Tasks.end()) return false;
+
+			task = std::move(iter->Function);
+			m_Tasks.erase(iter);
+		}
+		task();
+		return true;
+	}
+}
\ No newline at end of file